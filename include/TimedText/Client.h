@@ -41,6 +41,10 @@ class Client
 public:
   virtual ~Client() {}
   virtual void cuesAvailable() {}
+  // A parser emitting cues in order of start time was given 'cue', which
+  // starts before a cue it has already emitted (see
+  // WebVTTParser::setReorderWindow()).
+  virtual void lateCue(const Cue &cue) {}
 };
 
 }
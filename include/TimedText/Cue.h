@@ -82,6 +82,31 @@ public:
   ~Cue();
 
   Cue &operator=(const Cue &other);
+#if defined(TT_HAVE_RVALUE_REFS)
+  inline Cue(Cue &&other) : d(other.d) {
+    other.d = sharedEmpty();
+  }
+  inline Cue &operator=(Cue &&other) {
+    swap(other);
+    return *this;
+  }
+#endif
+
+  // Exchange the data of two handles, without touching reference counts
+  inline void swap(Cue &other) {
+    CueData *x = d;
+    d = other.d;
+    other.d = x;
+  }
+
+  // As with Node, these are pointer comparisons: handles are equal if they
+  // refer to the same cue, not to cues with the same contents.
+  inline bool operator==(const Cue &other) const {
+    return d == other.d;
+  }
+  inline bool operator!=(const Cue &other) const {
+    return d != other.d;
+  }
 
   CueType type() const;
   String id() const;
@@ -129,14 +154,23 @@ public:
   // Replace the tree of nodes
   bool setNodes(const Node &nodes);
 
-  void visit(NodeVisitor &visitor);
+  void visit(NodeVisitor &visitor) const;
 
 protected:
+  static CueData *sharedEmpty();
   CueData *d;
 };
 
 TT_DECLARE_TYPEINFO(Cue, TT_MOVABLE_TYPE);
 
+// Statically dispatched counterpart to Cue::visit(), see traverse(Node,...)
+template <typename Visitor>
+inline bool traverse(const Cue &cue, Visitor &visitor)
+{
+  Node tree;
+  return cue.nodes(tree) && traverse(tree, visitor);
+}
+
 }
 
 #endif // __TimedText_Cue__
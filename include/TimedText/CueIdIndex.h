@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __TimedText_CueIdIndex__
+#define __TimedText_CueIdIndex__
+
+#include <TimedText/Cue.h>
+#include <TimedText/List.h>
+
+namespace TimedText
+{
+
+// Index of cues by id, for ::cue(#id) selectors and chapter navigation,
+// which would otherwise compare the id of every cue.
+//
+// Cues are numbered in the order they are inserted. Ids are hashed into
+// buckets, so finding a cue takes constant time on average. Several cues
+// may share an id: lookups return the first of them to be inserted, and
+// the rest can be listed in insertion order. Cues without an id are
+// counted, but cannot be looked up.
+class CueIdIndex
+{
+public:
+  CueIdIndex();
+  explicit CueIdIndex(const List<Cue> &cues);
+  ~CueIdIndex();
+
+  bool insert(const Cue &cue);
+  bool insert(const List<Cue> &cues);
+
+  void clear();
+
+  inline int count() const {
+    return cues.count();
+  }
+
+  // Number of distinct ids
+  inline int idCount() const {
+    return numEntries;
+  }
+
+  // Number of the first cue with 'id', or -1 if there is none
+  int indexOf(const String &id) const;
+
+  // Set 'result' to the first cue with 'id'. Returns false if there is
+  // none.
+  bool find(const String &id, Cue &result) const;
+
+  // Append every cue with 'id' to 'result', in insertion order
+  bool findAll(const String &id, List<Cue> &result) const;
+
+  // Only call this if absolutely certain that 'i' is within bounds.
+  inline const Cue &cueAt(int i) const {
+    return cues.begin()[i];
+  }
+
+private:
+  struct Entry;
+  int findEntry(const String &id, uint32 hash) const;
+
+  List<Cue> cues;
+  // For each cue, the next cue with the same id, or -1
+  List<int> nextSame;
+  // One entry for each distinct id, with its text in 'ids', chained
+  // through Entry::next from 'buckets'
+  Entry *entries;
+  int numEntries;
+  int entryAlloc;
+  List<String> ids;
+  int *buckets;
+  int numBuckets;
+
+  // Not copyable
+  CueIdIndex(const CueIdIndex &);
+  CueIdIndex &operator=(const CueIdIndex &);
+};
+
+} // TimedText
+
+#endif // __TimedText_CueIdIndex__
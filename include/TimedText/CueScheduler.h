@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __TimedText_CueScheduler__
+#define __TimedText_CueScheduler__
+
+#include <TimedText/CueTimeline.h>
+
+namespace TimedText
+{
+
+// Tracks which cues become active or inactive as the playback position
+// moves, to drive the 'enter' and 'exit' events of HTML text tracks.
+//
+// During playback, cursors over the cues' start and end times are moved
+// forward past only the cues which changed state, so each update costs
+// little more than the number of cues reported. Seeking finds the new
+// position with binary searches, and the new active cues from a
+// CueTimeline.
+class CueScheduler
+{
+public:
+  CueScheduler();
+  explicit CueScheduler(const List<Cue> &cues);
+  ~CueScheduler();
+
+  // Returns false if the cue has a malformed start or end time, ends before
+  // it starts, or if memory could not be allocated. A cue inserted while it
+  // is active is reported as entered by the next update() or seek().
+  bool insert(const Cue &cue);
+  bool insert(const List<Cue> &cues);
+
+  void clear();
+
+  inline int count() const {
+    return startCues.count();
+  }
+
+  // Playback position of the last update() or seek(), or a malformed
+  // timestamp if there has not been one.
+  inline Timestamp currentTime() const {
+    return now;
+  }
+
+  // Cues active at currentTime(), in order of start time
+  inline void activeCues(List<Cue> &result) const {
+    result = active;
+  }
+
+  // Move the playback position forward to 'time', appending the cues which
+  // started to 'entered' (in order of start time), and those which ended to
+  // 'exited' (in order of end time). As in HTML, a cue which both started
+  // and ended since the last update was missed, and is reported as both
+  // entering and exiting.
+  //
+  // Moving backwards is treated as a seek.
+  bool update(Timestamp time, List<Cue> &entered, List<Cue> &exited);
+
+  // Jump to 'time', appending the cues which are active at 'time' but were
+  // not before to 'entered', and those which were active but are not now
+  // to 'exited'. Cues skipped over are not reported.
+  bool seek(Timestamp time, List<Cue> &entered, List<Cue> &exited);
+
+private:
+  struct Event;
+  bool grow();
+  bool insertEvent(Event *events, List<Cue> &cues, Milliseconds time,
+                   Milliseconds other, const Cue &cue);
+  bool insertActive(const Cue &cue);
+  static int findAfter(const Event *events, int count, Milliseconds time);
+
+  CueTimeline timeline;
+  // Cues sorted by start time and by end time, with cursors past the cues
+  // which have started or ended by 'now'
+  Event *starts;
+  Event *ends;
+  int alloc;
+  List<Cue> startCues;
+  List<Cue> endCues;
+  int nextStart;
+  int nextEnd;
+  Milliseconds now;
+  List<Cue> active;
+  // Cues which became active through insert()
+  List<Cue> pending;
+
+  // Not copyable
+  CueScheduler(const CueScheduler &);
+  CueScheduler &operator=(const CueScheduler &);
+};
+
+} // TimedText
+
+#endif // __TimedText_CueScheduler__
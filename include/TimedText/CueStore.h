@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __TimedText_CueStore__
+#define __TimedText_CueStore__
+
+#include <TimedText/Cue.h>
+#include <TimedText/List.h>
+
+namespace TimedText
+{
+
+struct PackedCueSettings;
+class TimeTransform;
+
+// Compact, append-only storage for large numbers of cues.
+//
+// Rather than a separately allocated CueData (with its own strings and
+// node tree) per cue, start and end times are kept in contiguous arrays,
+// settings are packed into a parallel array, and ids and text are stored
+// in one shared UTF-8 buffer. This costs 32 bytes per cue plus the text
+// itself.
+//
+// Cue handles are made on demand by cueAt(). Trees of nodes are not
+// stored; they can be parsed again from the cue text.
+class CueStore
+{
+public:
+  CueStore();
+  ~CueStore();
+
+  bool append(const Cue &cue);
+  bool append(const List<Cue> &cues);
+
+  void clear();
+
+  inline int count() const {
+    return numCues;
+  }
+
+  // Columns of start and end times, with count() entries each
+  inline const Milliseconds *startTimes() const {
+    return starts;
+  }
+  inline const Milliseconds *endTimes() const {
+    return ends;
+  }
+
+  // Only call these if absolutely certain that 'i' is within bounds.
+  inline Timestamp startTime(int i) const {
+    return Timestamp(starts[i]);
+  }
+  inline Timestamp endTime(int i) const {
+    return Timestamp(ends[i]);
+  }
+  String id(int i) const;
+  String text(int i) const;
+
+  // Make a new Cue with the times, id, text and settings of cue 'i'
+  bool cueAt(int i, Cue &result) const;
+
+  // Append the indices of the cues active at 'time' to 'result'. This scans
+  // every cue, but only touches the time columns.
+  bool activeCues(Timestamp time, List<int> &result) const;
+
+  // Apply 'transform' to the start and end time columns
+  void transform(const TimeTransform &transform);
+
+  // Bytes of id and text stored
+  inline int textSize() const {
+    return textLength;
+  }
+
+private:
+  bool grow();
+  bool appendText(const String &str);
+
+  int numCues;
+  int alloc;
+  Milliseconds *starts;
+  Milliseconds *ends;
+  PackedCueSettings *settings;
+  // Cue 'i' has its id at [offsets[2i], offsets[2i+1]) in 'buffer', and its
+  // text at [offsets[2i+1], offsets[2i+2])
+  int *offsets;
+  char *buffer;
+  int textLength;
+  int textAlloc;
+
+  // Not copyable
+  CueStore(const CueStore &);
+  CueStore &operator=(const CueStore &);
+};
+
+} // TimedText
+
+#endif // __TimedText_CueStore__
@@ -0,0 +1,170 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __TimedText_CueTextIndex__
+#define __TimedText_CueTextIndex__
+
+#include <TimedText/Cue.h>
+#include <TimedText/List.h>
+
+namespace TimedText
+{
+
+struct TextPosting;
+struct TextTerm;
+struct TextWord;
+
+// Inverted index of the words in the text of a set of cues, for searching
+// inside captions.
+//
+// Cues are numbered in the order they are added, and queries return the
+// numbers of the matching cues in increasing order; startTime() and
+// endTime() give their time ranges. The visible text of each cue (with
+// tags removed and character entities decoded) is split into words at
+// spaces and punctuation, and case is folded for ASCII, Latin-1, Greek and
+// Cyrillic letters. Each word is recorded with its position in the cue, so
+// that phrases can be matched.
+//
+// An index can be serialized into an image with writeImage(), which open()
+// uses in place, as from memory mapped with mmap(), in the manner of
+// TrackImage. Opened indexes cannot have cues added.
+//
+// Queries may finish sorting words added since the previous query, so an
+// index must not be used by several threads at once without locking.
+class CueTextIndex
+{
+public:
+  enum { Version = 1 };
+
+  // Words are truncated to this many bytes
+  enum { MaxWordLength = 64 };
+
+  CueTextIndex();
+  ~CueTextIndex();
+
+  // Index the text of 'cue' as cue number count()
+  bool add(const Cue &cue);
+  bool add(const List<Cue> &cues);
+
+  // Remove every cue, or close the image
+  void clear();
+
+  inline int count() const {
+    return numCues;
+  }
+
+  // Number of distinct words
+  int wordCount() const;
+
+  // Only call these if absolutely certain that 'i' is within bounds.
+  inline Timestamp startTime(int i) const {
+    return Timestamp(startColumn[i]);
+  }
+  inline Timestamp endTime(int i) const {
+    return Timestamp(endColumn[i]);
+  }
+
+  // Append to 'result' the cues containing the first word of 'word'
+  bool find(const String &word, List<int> &result) const;
+
+  // Append to 'result' the cues containing a word which begins with the
+  // first word of 'prefix'
+  bool findPrefix(const String &prefix, List<int> &result) const;
+
+  // Append to 'result' the cues containing the words of 'phrase', one
+  // directly after another
+  bool findPhrase(const String &phrase, List<int> &result) const;
+
+  // Size of the image written by writeImage(), or 0 if it would be too
+  // large
+  int imageSize() const;
+
+  // Serialize the index into 'data', which must be aligned to 8 bytes and
+  // hold at least imageSize() bytes.
+  bool writeImage(void *data, int size) const;
+
+  // Use an image written by writeImage(). 'data' must be aligned to 8
+  // bytes, and must remain valid until the index is cleared. Returns false
+  // if it is not an image of this version and byte order.
+  bool open(const void *data, int size);
+
+  inline bool isOpen() const {
+    return header != 0;
+  }
+
+private:
+  struct TermRecord;
+  struct Header;
+
+  bool lookup(const TextWord &word, const TextPosting *&postings,
+              int &n) const;
+  int sortTerms() const;
+  void sortedTerm(int rank, const char *&text, int &len,
+                  const TextPosting *&postings, int &n) const;
+  int findTerm(const TextWord &word, uint32 hash) const;
+  int addTerm(const TextWord &word, uint32 hash);
+  bool addPosting(int term, int position);
+  bool growCues();
+
+  // Cue times, in columns as in CueStore. 'startColumn' and 'endColumn'
+  // point to either these or the image.
+  int numCues;
+  int cueAlloc;
+  Milliseconds *starts;
+  Milliseconds *ends;
+  const Milliseconds *startColumn;
+  const Milliseconds *endColumn;
+
+  // Words added with add(), in the order they were first seen, and hash
+  // buckets of indices into 'terms' (chained through TextTerm::next)
+  TextTerm *terms;
+  int numTerms;
+  int termAlloc;
+  int *buckets;
+  int numBuckets;
+  char *chars;
+  int numChars;
+  int charAlloc;
+
+  // Indices into 'terms' in the order of their text. The first 'numSorted'
+  // are sorted, the rest are sorted by the next query. It has room for
+  // 2 * termAlloc entries, the second half being used for merging.
+  mutable int *sorted;
+  mutable int numSorted;
+
+  // When open() has been used, the image, and no terms
+  const Header *header;
+  const char *base;
+
+  // Not copyable
+  CueTextIndex(const CueTextIndex &);
+  CueTextIndex &operator=(const CueTextIndex &);
+};
+
+} // TimedText
+
+#endif // __TimedText_CueTextIndex__
@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __TimedText_CueTimeline__
+#define __TimedText_CueTimeline__
+
+#include <TimedText/Cue.h>
+#include <TimedText/List.h>
+
+namespace TimedText
+{
+
+// Index of cues by time, answering "which cues are active at time t?"
+// without scanning every cue.
+//
+// Cues are kept sorted by start time, forming an implicit binary tree in
+// which each node also records the latest end time beneath it. Queries skip
+// any subtree which ends too early, or which starts too late, so they take
+// time proportional to the log of the number of cues for each cue found.
+//
+// Cues may be inserted in any order, but inserting in order of start time
+// (as WebVTT files are normally written, and as WebVTTParser dispatches
+// them) is cheapest.
+class CueTimeline
+{
+public:
+  CueTimeline();
+  explicit CueTimeline(const List<Cue> &cues);
+  ~CueTimeline();
+
+  // Returns false if the cue has a malformed start or end time, or if
+  // memory could not be allocated.
+  bool insert(const Cue &cue);
+  bool insert(const List<Cue> &cues);
+
+  void clear();
+
+  inline int count() const {
+    return cues.count();
+  }
+
+  // Append the cues active at 'time' (those starting at or before 'time'
+  // and ending after it) to 'result', in order of start time.
+  bool activeCues(Timestamp time, List<Cue> &result) const;
+
+  // Append the cues active at any point in [from, to) to 'result', in order
+  // of start time.
+  bool cuesBetween(Timestamp from, Timestamp to, List<Cue> &result) const;
+
+private:
+  struct Entry;
+  bool append(const Entry &entry);
+  bool grow();
+  void rebuild();
+  bool collect(int i, int level, Milliseconds from, Milliseconds to,
+               List<Cue> &result) const;
+  bool insertCue(const Cue &cue, bool &reordered);
+
+  // Tree nodes, including unused ones past the last cue
+  Entry *entries;
+  int numEntries;
+  int rootLevel;
+  List<Cue> cues;
+
+  // Not copyable
+  CueTimeline(const CueTimeline &);
+  CueTimeline &operator=(const CueTimeline &);
+};
+
+} // TimedText
+
+#endif // __TimedText_CueTimeline__
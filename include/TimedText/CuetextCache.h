@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __TimedText_CuetextCache__
+#define __TimedText_CuetextCache__
+
+#include <TimedText/Node.h>
+#include <TimedText/StringPool.h>
+
+namespace TimedText
+{
+
+// Interning cache of parsed cue text. Cues with byte-identical text, such as
+// those of roll-up or karaoke captions, can share a single tree of Nodes
+// rather than each parsing and storing their own.
+//
+// Like any Node, a shared tree is copied before being modified through one
+// of its handles, so modifying one cue's nodes leaves the others intact. A
+// cache is not safe to use from multiple threads at once.
+class CuetextCache
+{
+public:
+  // 'capacity' is the maximum number of trees held. When the cache is full,
+  // one of the older trees is dropped to make room for another.
+  CuetextCache(int capacity = 256);
+  ~CuetextCache();
+
+  // Look up the tree of nodes stored for 'cuetext'
+  bool find(const String &cuetext, Node &result) const;
+
+  // Store 'tree' for 'cuetext', replacing any tree already stored for it.
+  bool insert(const String &cuetext, const Node &tree);
+
+  void clear();
+
+  inline int count() const {
+    return numEntries;
+  }
+
+  // Class names, voice names and language tags of the cached trees
+  inline StringPool &strings() {
+    return pool;
+  }
+
+  inline int capacity() const {
+    return maxEntries;
+  }
+
+private:
+  struct Entry;
+  Entry **buckets;
+  int numBuckets;
+  int numEntries;
+  int maxEntries;
+  // Bucket to evict from next
+  int evictCursor;
+  StringPool pool;
+
+  // Not copyable
+  CuetextCache(const CuetextCache &);
+  CuetextCache &operator=(const CuetextCache &);
+};
+
+} // TimedText
+
+#endif // __TimedText_CuetextCache__
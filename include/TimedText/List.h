@@ -65,6 +65,7 @@ struct ListData
   Data *detach(int alloc);
   Data *detach_grow(int *i, int n);
   bool realloc(int alloc);
+  bool reserve(int alloc);
   void **erase(void **xi);
   inline void **append(const ListData &other) {
     return append(size());
@@ -149,6 +150,17 @@ public:
     return p.unique() || detachHelper();
   }
 
+  // Make room for at least 'size' items, so that adding items up to that
+  // many does not need to reallocate.
+  bool reserve(int size) {
+    if(!p.unique() && !detachHelper(size > p.alloc() ? size : p.alloc()))
+      return false;
+    return p.reserve(size);
+  }
+
+  // Number of items which can be held without reallocating
+  inline int capacity() const { return p.alloc(); }
+
   // All synonyms for the same thing (length of list)
   inline int length() const { return p.size(); }
   inline int size() const { return length(); }
@@ -222,6 +234,43 @@ public:
     return true;
   }
 
+#if defined(TT_HAVE_RVALUE_REFS)
+  // As above, but move from 'item' rather than copying it
+  inline bool insert(int i, T &&item) {
+    return insertMoved(i, item);
+  }
+#endif
+#if defined(TT_HAVE_VARIADIC_TEMPLATES)
+  // Insert an item constructed from 'args' at position 'i'
+  template <typename... Args>
+  inline bool emplace(int i, Args&&... args) {
+    if(TypeInfo<T>::isLarge || TypeInfo<T>::isStatic) {
+      Node *n = insertNode(i);
+      if(!n)
+        return false;
+      if(!nodeEmplace(n, static_cast<Args&&>(args)...)) {
+        removeNode(n);
+        return false;
+      }
+    } else {
+      // Constructed before making room, in case 'args' refer to items
+      Node *n, copy;
+      nodeEmplace(&copy, static_cast<Args&&>(args)...);
+      if(!(n = insertNode(i))) {
+        nodeDestruct(&copy);
+        return false;
+      }
+      *n = copy;
+    }
+    return true;
+  }
+  // Add an item constructed from 'args' to the end
+  template <typename... Args>
+  inline bool emplaceBack(Args&&... args) {
+    return emplace(INT_MAX, static_cast<Args&&>(args)...);
+  }
+#endif
+
   // Take from arbitrary position
   inline bool take(int i, T &result) {
     if(i < 0 || i >= p.size())
@@ -299,6 +348,16 @@ public:
     return true;
   }
 
+#if defined(TT_HAVE_RVALUE_REFS)
+  // As above, but move from 'item' rather than copying it
+  inline bool unshift(T &&item) {
+    return insertMoved(0, item);
+  }
+  inline bool push(T &&item) {
+    return insertMoved(INT_MAX, item);
+  }
+#endif
+
   inline bool shift() {
     if(!p.size())
       return false;
@@ -476,6 +535,58 @@ private:
   inline T &last() { return *(--end()); }
   inline const T &last() const { return at(count() - 1); }
 
+  // Make room for an item at position 'i', as insert() does
+  inline Node *insertNode(int i) {
+    if(!p.unique())
+      return detachHelperGrow(i, 1);
+    return reinterpret_cast<Node *>(p.insert(i));
+  }
+
+  inline void removeNode(Node *n) {
+    p.remove(int(n - reinterpret_cast<Node *>(p.begin())));
+  }
+
+#if defined(TT_HAVE_RVALUE_REFS)
+  inline bool insertMoved(int i, T &item) {
+    if(TypeInfo<T>::isLarge || TypeInfo<T>::isStatic) {
+      Node *n = insertNode(i);
+      if(!n)
+        return false;
+      if(!nodeMove(n, item)) {
+        removeNode(n);
+        return false;
+      }
+    } else {
+      // Moved before making room, in case 'item' is in the list
+      Node *n, copy;
+      nodeMove(&copy, item);
+      if(!(n = insertNode(i))) {
+        nodeDestruct(&copy);
+        return false;
+      }
+      *n = copy;
+    }
+    return true;
+  }
+
+  inline bool nodeMove(Node *n, T &item) {
+    if(TypeInfo<T>::isLarge || TypeInfo<T>::isStatic)
+      return !!(n->v = new T(static_cast<T&&>(item)));
+    new (n) T(static_cast<T&&>(item));
+    return true;
+  }
+#endif
+
+#if defined(TT_HAVE_VARIADIC_TEMPLATES)
+  template <typename... Args>
+  inline bool nodeEmplace(Node *n, Args&&... args) {
+    if(TypeInfo<T>::isLarge || TypeInfo<T>::isStatic)
+      return !!(n->v = new T(static_cast<Args&&>(args)...));
+    new (n) T(static_cast<Args&&>(args)...);
+    return true;
+  }
+#endif
+
   inline bool nodeConstruct(Node *n, const T &item) {
     if(TypeInfo<T>::isLarge || TypeInfo<T>::isStatic)
       return !!(n->v = new T(item));
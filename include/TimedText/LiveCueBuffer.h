@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __TimedText_LiveCueBuffer__
+#define __TimedText_LiveCueBuffer__
+
+#include <TimedText/Cue.h>
+#include <TimedText/List.h>
+
+namespace TimedText
+{
+
+// Cues of a live stream, keeping only those which end within a retention
+// period of the live edge, so that a client appending the output of
+// WebVTTParser::parsedCues() for days does not grow without bound.
+//
+// The live edge is the latest start time of any cue appended, or a later
+// time given to setLiveEdge(). Cues are kept in order of end time, so the
+// expired ones are always at the front, and evicting them takes time
+// proportional to their number. Once no other handle refers to them, their
+// text and trees of nodes are freed.
+class LiveCueBuffer
+{
+public:
+  explicit LiveCueBuffer(Milliseconds retention = 60000);
+
+  // Returns false if the cue has a malformed start or end time, or if
+  // memory could not be allocated. Cues which have already expired are
+  // dropped.
+  bool append(const Cue &cue);
+  bool append(const List<Cue> &cues);
+
+  // Move the live edge forward (for instance, to the end of the latest
+  // media segment), evicting cues which expire. It never moves back.
+  void setLiveEdge(Timestamp edge);
+  inline Timestamp liveEdge() const {
+    return Timestamp(edge);
+  }
+
+  void setRetention(Milliseconds retention);
+  inline Milliseconds retention() const {
+    return keep;
+  }
+
+  void clear();
+
+  inline int count() const {
+    return cues.count();
+  }
+
+  // Number of cues evicted or dropped since the buffer was made
+  inline int evictedCount() const {
+    return numEvicted;
+  }
+
+  // Only call this if absolutely certain that 'i' is within bounds.
+  inline const Cue &cueAt(int i) const {
+    return cues.begin()[i];
+  }
+
+  // Set 'result' to the cues held, in order of end time. The list is
+  // shared until either is modified.
+  inline void liveCues(List<Cue> &result) const {
+    result = cues;
+  }
+
+private:
+  void evict();
+
+  // Cues, and their end times, in order of end time
+  List<Cue> cues;
+  List<Milliseconds> ends;
+  Milliseconds edge;
+  Milliseconds keep;
+  int numEvicted;
+};
+
+} // TimedText
+
+#endif // __TimedText_LiveCueBuffer__
@@ -105,6 +105,22 @@ public:
   ~Node();
 
   Node &operator=(const Node &other);
+#if defined(TT_HAVE_RVALUE_REFS)
+  inline Node(Node &&other) : d(other.d) {
+    other.d = sharedEmpty();
+  }
+  inline Node &operator=(Node &&other) {
+    swap(other);
+    return *this;
+  }
+#endif
+
+  // Exchange the data of two handles, without touching reference counts
+  inline void swap(Node &other) {
+    NodeData *x = d;
+    d = other.d;
+    other.d = x;
+  }
 
   // These are pointer comparisons, nothing more!
   // Do not expect any deep equality checks here.
@@ -127,6 +143,11 @@ public:
   String voice() const;
   // Text if elementType == TextNode
   String text() const;
+  // Text if elementType == TextNode, converted to UTF-16 (see
+  // String::toUtf16())
+  inline bool textToUtf16(uint16 *out, int alloc, int &olen) const {
+    return text().toUtf16(out, alloc, olen);
+  }
   // BCP47 Language Code if elementType == LangNode
   String lang() const;
 
@@ -155,6 +176,12 @@ public:
   // Wrappers for list routines in internal nodes.
   // Will always fail for leaf nodes.
   bool push(const Node &node);
+#if defined(TT_HAVE_RVALUE_REFS)
+  // As above, but move from 'node' rather than copying it
+  inline bool push(Node &&node) {
+    return pushMoved(node);
+  }
+#endif
   bool pop(Node &result);
   bool unshift(const Node &node);
   bool shift(Node &result);
@@ -171,23 +198,90 @@ public:
   const_iterator end() const;
 
   // Traverse node tree with a hierarchical visitor, allowing
-  // branches to be optionally traversed or not.
-  void visit(NodeVisitor &visitor);
+  // branches to be optionally traversed or not. See also traverse(),
+  // which does the same without virtual dispatch.
+  void visit(NodeVisitor &visitor) const;
 
 private:
+  // Node handles are copy-on-write: the setters and list routines above
+  // first replace data which is referenced by other handles (for instance,
+  // as the child of some other node) with a private copy. Copies are
+  // shallow, children are shared until they are modified in turn.
+  bool detach();
+  bool pushMoved(Node &node);
+  static NodeData *sharedEmpty();
   NodeData *d;
 };
 
 TT_DECLARE_TYPEINFO(Node,TT_MOVABLE_TYPE);
 
+// The tree being visited may be shared with other handles, so traversal
+// passes each node to visit(const Node &). Unless overridden, it calls
+// visit(Node &) with a copy of the node's handle: visitors which change
+// that node then change their own copy, and leave the tree as it was. To
+// modify a tree in place, walk it through the non-const iterators instead
+// (see TimeTransform::apply(Node &)).
 class NodeVisitor
 {
 public:
   virtual bool enter(const Node &node) { return true; }
   virtual void leave(const Node &node) {}
+  virtual void visit(const Node &node) {
+    Node copy(node);
+    visit(copy);
+  }
   virtual void visit(Node &node) {}
 };
 
+// Statically dispatched counterpart to Node::visit(). 'visitor' may be any
+// object providing the enter(), leave() and visit() members of NodeVisitor,
+// but they need not be virtual, so they can be inlined into the loop below.
+//
+// The tree is walked with an explicit stack rather than by recursion, so
+// deeply nested cue text cannot exhaust the call stack. Returns false if
+// the stack could not be grown.
+template <typename Visitor>
+inline bool traverse(const Node &root, Visitor &visitor)
+{
+  // Parallel stacks of branches and the index of the next child to visit
+  // in each. Both element types are stored inline in the list, so descending
+  // does not allocate once the lists have grown.
+  List<Node> branches;
+  List<int> positions;
+  if(!branches.push(root) || !positions.push(0))
+    return false;
+  while(!branches.isEmpty()) {
+    int top = branches.count() - 1;
+    const List<Node> &children = branches[top].children();
+    int i = positions[top];
+    if(i < children.count()) {
+      positions[top] = i + 1;
+      const Node &child = children.begin()[i];
+      // Don't visit empty nodes.
+      if(child.type() == EmptyNode)
+        continue;
+      // Visit the item before descending
+      visitor.visit(child);
+      if(child.type() == InternalNode && child.childCount() > 0
+         && (child.element() == InternalTextNode || visitor.enter(child))) {
+        if(!branches.push(child))
+          return false;
+        if(!positions.push(0)) {
+          branches.pop();
+          return false;
+        }
+      }
+    } else {
+      // Notify visitor that we are leaving a branch of the tree
+      if(branches[top].element() != InternalTextNode)
+        visitor.leave(branches[top]);
+      branches.pop();
+      positions.pop();
+    }
+  }
+  return true;
+}
+
 }
 
 #endif // __TimedText_Node__
@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __TimedText_ParseCache__
+#define __TimedText_ParseCache__
+
+#include <TimedText/Cue.h>
+#include <TimedText/List.h>
+
+namespace TimedText
+{
+
+// Cache of parsed WebVTT documents, keyed by a hash of their content and
+// the options they were parsed with, for servers which are asked for the
+// same documents over and over.
+//
+// A cache may be shared between threads. When several threads ask for the
+// same document at once, one parses it while the others wait for its
+// result. Each caller is given cues of its own, which share their ids, text
+// and node trees with the cached cues, so that they may be modified freely.
+//
+// Entries are found by a 64-bit hash of the document, and keep a copy of it
+// which is compared on every hit. Documents which are not WebVTT are cached
+// as failures, but parses which ran out of memory are not.
+class ParseCache
+{
+public:
+  enum Flags
+  {
+    NoFlags = 0,
+    // Also parse the text of each cue into a tree of nodes
+    ParseCuetext = 1
+  };
+
+  // 'budget' is the approximate number of bytes of cues to keep. The least
+  // recently used documents are dropped to stay within it.
+  ParseCache(int budget = 32 * 1024 * 1024);
+  ~ParseCache();
+
+  // Set 'result' to the cues of the WebVTT document 'data', parsing it
+  // only if it is not already cached. Returns false if the document could
+  // not be parsed.
+  bool parse(const char *data, int len, List<Cue> &result,
+             int flags = NoFlags);
+
+  // Drop every document which is not being parsed
+  void clear();
+
+  int count() const;
+
+  // Approximate bytes held, counting each document's length plus a fixed
+  // amount for each of its cues
+  int cost() const;
+
+  inline int budget() const {
+    return maxCost;
+  }
+
+  // Number of parse() calls answered from the cache, and number which
+  // parsed the document
+  int hits() const;
+  int misses() const;
+
+private:
+  struct Entry;
+  struct Shared;
+  Entry *find(uint64 hash, const char *data, int len, int flags) const;
+  bool insert(Entry *e);
+  void remove(Entry *e);
+  void evict();
+
+  Shared *shared;
+  Entry **buckets;
+  int numBuckets;
+  int numEntries;
+  int totalCost;
+  int maxCost;
+  int numHits;
+  int numMisses;
+  // Least recently used list of finished entries
+  Entry *newest;
+  Entry *oldest;
+
+  // Not copyable
+  ParseCache(const ParseCache &);
+  ParseCache &operator=(const ParseCache &);
+};
+
+} // TimedText
+
+#endif // __TimedText_ParseCache__
@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#ifndef __TimedText_SegmentedStringBuilder__
+#define __TimedText_SegmentedStringBuilder__
+
+#include <TimedText/String.h>
+
+namespace TimedText
+{
+
+class StringBuilder;
+
+// SegmentedStringBuilder accumulates UTF-8 text in a list of separately
+// allocated segments. Unlike StringBuilder, growing it never moves text
+// which has already been appended, which makes it suited to building very
+// large outputs, such as a whole serialized track. Long Strings are appended
+// by sharing their buffers, without copying them at all.
+//
+// The segments can be written out directly, for instance with writev(), or
+// flattened into a single String.
+//
+// As with StringBuilder, bad UTF8 and unicode non-characters are converted
+// to the unicode replacement character (U+FFFD).
+class SegmentedStringBuilder
+{
+public:
+  // A contiguous run of the builder's text
+  struct Segment
+  {
+    const char *text;
+    int length;
+  };
+
+  // 'segmentSize' is the size of each buffer allocated for appended text
+  SegmentedStringBuilder(int segmentSize = 4096);
+  ~SegmentedStringBuilder();
+
+  inline int length() const {
+    return totalLength;
+  }
+
+  inline bool isEmpty() const {
+    return totalLength == 0;
+  }
+
+  inline int segmentCount() const {
+    return numChunks;
+  }
+
+  // Store up to 'max' segments, starting with segment 'first', in 'out'.
+  // Returns the number of segments stored.
+  int segments(Segment *out, int max, int first = 0) const;
+
+  bool append(const char *text, int len);
+  inline bool append(const char *text) {
+    return append(text, -1);
+  }
+  bool append(uint32 ucs4);
+  // Strings of at least half a segment are shared rather than copied
+  bool append(const String &str);
+  bool append(const StringBuilder &buf);
+
+  // Flatten the text into a single String
+  bool toString(String &result) const;
+
+  void clear();
+
+private:
+  struct Chunk;
+  Chunk *first;
+  Chunk *last;
+  int numChunks;
+  int totalLength;
+  int chunkSize;
+
+  char *reserve(int size);
+
+  // Not copyable
+  SegmentedStringBuilder(const SegmentedStringBuilder &);
+  SegmentedStringBuilder &operator=(const SegmentedStringBuilder &);
+};
+
+} // TimedText
+
+#endif // __TimedText_SegmentedStringBuilder__
@@ -40,6 +40,10 @@ namespace TimedText
 class StringBuilder;
 
 // String is an immutable, shared, UTF-8 encoded representation of text.
+//
+// Strings of up to SmallCapacity bytes are stored inline, without any heap
+// allocation or reference counting. Longer strings share a reference counted
+// buffer.
 class String
 {
 public:
@@ -52,11 +56,41 @@ public:
   String &operator=(const String &str);
   String &operator+=(const String &str);
 
+  // Copy 'len' bytes of text which is already known to be valid UTF-8, such
+  // as text previously taken from Strings, without checking it again.
+  static String fromValidUtf8(const char *utf8, int len);
+
+#ifdef TT_HAVE_RVALUE_REFS
+  // Moving leaves the source string NULL
+  inline String(String &&str) : tag(str.tag) {
+    ::memcpy(small, str.small, sizeof(small));
+    str.tag = NullTag;
+    str.small[0] = '\0';
+  }
+  inline String &operator=(String &&str) {
+    swap(str);
+    return *this;
+  }
+#endif
+
+  // Exchanges the contents of two strings, without touching reference counts
+  inline void swap(String &other) {
+    char tmp[sizeof(small)];
+    ::memcpy(tmp, small, sizeof(small));
+    ::memcpy(small, other.small, sizeof(small));
+    ::memcpy(other.small, tmp, sizeof(small));
+    unsigned char t = tag;
+    tag = other.tag;
+    other.tag = t;
+  }
+
   // Returns true if the string is empty or NULL.
   inline bool isEmpty() const {
     return length() == 0;
   }
 
+  // Returns true if the string was constructed from a NULL pointer, or
+  // default constructed.
   bool isNull() const;
 
   int length() const;
@@ -82,6 +116,27 @@ public:
       *this = String();
   }
 
+  // Length of the text in UTF-16 code units
+  inline int utf16Length() const {
+    return Unicode::utf16Length(text(), length());
+  }
+
+  // Convert the text to UTF-16, storing at most 'alloc' code units in 'out'
+  // and their number in 'olen'. Returns false if 'out' is too small.
+  inline bool toUtf16(uint16 *out, int alloc, int &olen) const {
+    return Unicode::toUtf16(out, alloc, olen, text(), length());
+  }
+
+  // Hash of the text, which is the same for any two equal strings. It is
+  // computed once for each shared buffer, and stored with it.
+  uint32 hash() const;
+
+  // Strings are equal if their text is byte-for-byte identical
+  bool operator==(const String &other) const;
+  inline bool operator!=(const String &other) const {
+    return !operator==(other);
+  }
+
   int indexOf(const char *text, int len=-1, int from = 0) const;
   inline int indexOf(const String &str, int from = 0) const {
     return indexOf(str.text(), str.length(), from);
@@ -141,22 +196,45 @@ public:
   }
   int skipUntilWhitespace(int &position) const;
 
+  // Largest length of a string stored inline
+  enum { SmallCapacity = 22 };
+
 private:
   friend class StringBuilder;
+  friend class SegmentedStringBuilder;
   static int findString(const char *bucket, int bucket_len, int from,
                         const char *needle, int needle_len);
   static int findStringBoyerMoore(const char *bucket, int bucket_len, int from,
                                   const char *needle, int needle_len);
 
-  Data *d;
-  static Data sharedNull;
-  static Data sharedEmpty;
-  void freeData(Data *x);
-  bool realloc(int size);
+  // Values of 'tag' which are not inline lengths
+  enum { NullTag = 0xfe, HeapTag = 0xff };
+  inline bool isSmall() const {
+    return tag != HeapTag;
+  }
+  union {
+    Data *d;
+    char small[SmallCapacity + 1];
+  };
+  unsigned char tag;
+
+  char *allocate(int size);
+  void setLength(int size);
+  void release();
+  static void freeData(Data *x);
 };
 
 TT_DECLARE_TYPEINFO(String, TT_MOVABLE_TYPE);
 
+// Hash function object for Strings, for use with hash tables such as
+// std::unordered_map
+struct StringHash
+{
+  inline size_t operator()(const String &str) const {
+    return str.hash();
+  }
+};
+
 } // TimedText
 
 #endif // __TimedText_String__
@@ -55,6 +55,10 @@ public:
   ~StringBuilder();
 
   bool toString(String &result) const;
+  // Let result be the builder's text, handing over the builder's buffer
+  // rather than copying it where possible. The builder is left empty; if
+  // it is to be reused, it is given a new buffer of the same capacity.
+  bool takeString(String &result, bool reuse = false);
   inline int length() const {
     return d->length;
   }
@@ -152,6 +156,9 @@ private:
     static Data *allocate(Data *old, int size);
     int alloc;
     int length;
+    // Unused, but gives Data the layout of String::Data, so that
+    // takeString() can turn it into one.
+    uint32 reserved;
     char text[1];
   };
   Data *d;
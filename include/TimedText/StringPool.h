@@ -0,0 +1,85 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#ifndef __TimedText_StringPool__
+#define __TimedText_StringPool__
+
+#include <TimedText/String.h>
+
+namespace TimedText
+{
+
+// Interning table of Strings. Strings which recur throughout a document,
+// such as class names, voice names and language tags, can be looked up here
+// rather than each occurrence allocating its own copy. Interned Strings share
+// a single buffer, even those short enough to be stored inline, so they can
+// be compared by their text() pointers. Text which is not valid UTF-8 is
+// never pooled.
+//
+// A pool is not safe to use from multiple threads at once.
+class StringPool
+{
+public:
+  // 'capacity' is the maximum number of Strings held. When the pool is full,
+  // one of the older Strings is dropped to make room for another. Strings
+  // previously returned remain valid.
+  StringPool(int capacity = 1024);
+  ~StringPool();
+
+  // Let result be the pooled String equal to the UTF-8 'text', adding it to
+  // the pool if it is not yet present.
+  bool intern(const char *text, int len, String &result);
+  inline bool intern(const String &str, String &result) {
+    return intern(str.text(), str.length(), result);
+  }
+
+  void clear();
+
+  inline int count() const {
+    return numEntries;
+  }
+
+  inline int capacity() const {
+    return maxEntries;
+  }
+
+private:
+  struct Entry;
+  Entry **buckets;
+  int numBuckets;
+  int numEntries;
+  int maxEntries;
+  // Bucket to evict from next
+  int evictCursor;
+
+  // Not copyable
+  StringPool(const StringPool &);
+  StringPool &operator=(const StringPool &);
+};
+
+} // TimedText
+
+#endif // __TimedText_StringPool__
@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __TimedText_TimeTransform__
+#define __TimedText_TimeTransform__
+
+#include <TimedText/Cue.h>
+#include <TimedText/List.h>
+
+namespace TimedText
+{
+
+// A change of timing applied to many cues at once, for instance to resync
+// a track, or to convert it between frame rates.
+//
+// Each time is first scaled by a ratio of integers, then shifted by an
+// offset, then clamped into a window. Scaling is exact: the result is
+// rounded to the nearest millisecond, with halves rounded up. Malformed
+// times are left as they are, and times are never made negative: the
+// window is always within [0, 2^62] milliseconds.
+//
+// The work is done over contiguous arrays of times, in loops without
+// branches, so that compilers may vectorize them.
+class TimeTransform
+{
+public:
+  // The identity transform
+  TimeTransform();
+
+  // Multiply times by numerator / denominator. Converting a 25fps track to
+  // 23.976fps (24000/1001) is setScale(25025, 24000). Fails unless both
+  // are positive.
+  bool setScale(int numerator, int denominator);
+
+  // Add 'offset' (which may be negative) to times after scaling
+  void setOffset(Milliseconds offset);
+
+  // Clamp times into [first, last] after shifting
+  void setWindow(Milliseconds first, Milliseconds last);
+
+  inline bool isIdentity() const {
+    return num == den && offset == 0 && first == 0 && last == maxTime();
+  }
+
+  Timestamp apply(const Timestamp &time) const;
+
+  // Transform 'count' times in place
+  void apply(Milliseconds *times, int count) const;
+
+  // Transform the start and end times of each cue, and any TimestampNodes
+  // in their trees of nodes. The cue text is left as it is. Times are read
+  // and written one cue at a time; CueStore::transform() works on whole
+  // columns of times instead.
+  bool apply(List<Cue> &cues) const;
+  bool apply(Cue &cue) const;
+
+  // Transform every TimestampNode in 'tree'. Nodes shared with other trees
+  // are copied before they are modified (see Node), but only those on the
+  // path to a TimestampNode whose time changes.
+  bool apply(Node &tree) const;
+
+  // Largest time a transform produces
+  static inline Milliseconds maxTime() {
+    return Milliseconds(1) << 62;
+  }
+
+private:
+  void shift(Milliseconds *times, int count) const;
+  void scaleAndShift(Milliseconds *times, int count) const;
+  bool applyToNodes(Cue &cue) const;
+
+  int64 num;
+  int64 den;
+  Milliseconds offset;
+  Milliseconds first;
+  Milliseconds last;
+};
+
+} // TimedText
+
+#endif // __TimedText_TimeTransform__
@@ -0,0 +1,141 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __TimedText_TrackImage__
+#define __TimedText_TrackImage__
+
+#include <TimedText/Cue.h>
+#include <TimedText/List.h>
+
+namespace TimedText
+{
+
+struct PackedCueSettings;
+
+// A parsed track, serialized into a binary image which can be stored (for
+// instance, in a cache file) and later used in place, such as from memory
+// mapped with mmap(), without being parsed or deserialized again.
+//
+// The image holds only offsets rather than pointers, so it may be mapped at
+// any address. It begins with a header giving its version and the positions
+// of columns of start times, end times, packed settings, and offsets into
+// a shared UTF-8 text area holding cue ids and text. Optionally, a stream of
+// flattened node trees and the text they refer to follows. Values are stored
+// in the byte order of the writer, and readers reject images of the other
+// byte order.
+class TrackImage
+{
+public:
+  enum { Version = 1 };
+
+  TrackImage();
+
+  // Use an image written by TrackImageWriter. 'data' must be aligned to 8
+  // bytes, and must remain valid until the image is closed. Returns false if
+  // it is not an image of this version and byte order.
+  bool open(const void *data, int size);
+  void close();
+
+  inline bool isOpen() const {
+    return header != 0;
+  }
+
+  int count() const;
+
+  // True if the image holds trees of nodes for its cues
+  bool hasNodes() const;
+
+  // Columns of start and end times, with count() entries each
+  const Milliseconds *startTimes() const;
+  const Milliseconds *endTimes() const;
+
+  // Only call these if absolutely certain that 'i' is within bounds.
+  inline Timestamp startTime(int i) const {
+    return Timestamp(startTimes()[i]);
+  }
+  inline Timestamp endTime(int i) const {
+    return Timestamp(endTimes()[i]);
+  }
+  String id(int i) const;
+  String text(int i) const;
+
+  // Make a new Cue from cue 'i' of the image, including its tree of nodes
+  // if the image holds one.
+  bool cueAt(int i, Cue &result) const;
+
+  // Build the tree of nodes stored for cue 'i'
+  bool nodes(int i, Node &result) const;
+
+private:
+  struct Header;
+  const PackedCueSettings *settings() const;
+  bool stringAt(uint32 area, uint32 areaSize, uint32 offset, uint32 length,
+                String &result) const;
+  friend class TrackImageWriter;
+
+  const Header *header;
+  const char *base;
+};
+
+// Serializes cues into a TrackImage.
+class TrackImageWriter
+{
+public:
+  enum Flags
+  {
+    NoFlags = 0,
+    // Store trees of nodes. Cues without a tree have their text parsed.
+    IncludeNodes = 1
+  };
+
+  TrackImageWriter();
+  ~TrackImageWriter();
+
+  // Replace the image with one holding 'cues'
+  bool write(const List<Cue> &cues, int flags = NoFlags);
+
+  void clear();
+
+  inline const char *data() const {
+    return image;
+  }
+  inline int size() const {
+    return imageSize;
+  }
+
+private:
+  char *image;
+  int imageSize;
+
+  // Not copyable
+  TrackImageWriter(const TrackImageWriter &);
+  TrackImageWriter &operator=(const TrackImageWriter &);
+};
+
+} // TimedText
+
+#endif // __TimedText_TrackImage__
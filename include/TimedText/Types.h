@@ -69,6 +69,13 @@ typedef unsigned __int64 uint64;
 #endif
 
 // Typeinfo, needed for container class magic
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1600)
+#  define TT_HAVE_RVALUE_REFS
+#endif
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1800)
+#  define TT_HAVE_VARIADIC_TEMPLATES
+#endif
+
 template <typename T>
 class TypeInfo
 {
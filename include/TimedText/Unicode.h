@@ -126,6 +126,22 @@ public:
   static bool toValidUtf8(char *out, int alloc, int &olen,
                           const char *in, int len);
 
+  // Copy the longest prefix of 'in' which is valid UTF8 to 'out', which must
+  // have room for 'len' bytes, and return its length. Runs of ASCII are
+  // copied many bytes at a time where possible.
+  static int copyValidUtf8(char *out, const char *in, int len);
+
+  // Return length in UTF-16 code units of valid UTF8 text, such as that of
+  // a String.
+  static int utf16Length(const char *utf8, int len);
+
+  // Convert valid UTF8 text to UTF-16, storing at most 'alloc' code units
+  // in 'out' and their number in 'olen'. Returns false if 'out' is too small
+  // to hold all of the text. Runs of ASCII are widened many bytes at a time
+  // where possible.
+  static bool toUtf16(uint16 *out, int alloc, int &olen,
+                      const char *in, int len);
+
   // Convert a single UCS4 character to UTF8 ('out' is assumed to be
   // large enough to contain a UTF8 character). Returns false if the
   // character is not a unicode character, in which case the replacement
@@ -37,6 +37,8 @@
 namespace TimedText
 {
 
+class CuetextCache;
+class StringPool;
 class WebVTTParser
 {
 public:
@@ -59,6 +61,14 @@ public:
     WithBOM,
     WithoutBOM
   };
+  enum PlainTextFlags {
+    PlainTextDefault = 0,
+    // Include the text of <rt> annotations, enclosed in parentheses after
+    // the base text
+    IncludeRubyText = 1,
+    // Prefix the contents of <v> spans with the speaker's name and a colon
+    IncludeVoicePrefix = 2,
+  };
   enum HeaderStatus {
     InitialHeader = 0,
     TagHeader, // Reading 'WEBVTT' tag
@@ -84,11 +94,42 @@ public:
   // expect the cues to be appended to it!
   void parsedCues(List<Cue> &result);
 
+  // Emit cues in order of start time, rather than document order. Each cue
+  // is held until a cue starting at least 'window' after it is parsed, or
+  // until the document ends, so cues may be out of order by up to 'window'
+  // in the document while only that many are held. A negative window (the
+  // default) emits cues as they are parsed.
+  void setReorderWindow(Milliseconds window);
+  inline Milliseconds reorderWindow() const {
+    return windowSize;
+  }
+
+  // Number of cues which started before a cue already emitted, and so
+  // could not be emitted in order. These are emitted as soon as they are
+  // parsed, and reported to Client::lateCue().
+  inline int lateCueCount() const {
+    return numLateCues;
+  }
+
   // Translate WebVTT CueText into a tree of Node objects
   static bool cuetextToNodes(const String &cuetext, Node &tree);
+  // As above, but take class names, voice names and language tags from
+  // 'strings', so that each distinct one is stored once.
+  static bool cuetextToNodes(const String &cuetext, Node &tree,
+                             StringPool &strings);
+  // As above, but share the tree with any other identical cue text parsed
+  // using the same cache, and intern strings in the cache's StringPool.
+  static bool cuetextToNodes(const String &cuetext, Node &tree,
+                             CuetextCache &cache);
+  // Append the visible text of WebVTT CueText to result, with tags removed
+  // and character entities decoded, without building a tree of Nodes.
+  // 'flags' is a combination of PlainTextFlags.
+  static bool cuetextToPlainText(const String &cuetext, StringBuilder &result,
+                                 int flags = PlainTextDefault);
   // Convenience method of replacing the cue's nodes with nodes from
   // cuetextToNodes() using its body text.
   static bool parseCuetext(Cue &cue);
+  static bool parseCuetext(Cue &cue, CuetextCache &cache);
   static Timestamp collectTimestamp(const String &line, int &position);
 
 private:
@@ -100,6 +141,10 @@ private:
 
   void dispatchCue();
   void dropCue();
+  void holdCue(const Cue &cue);
+  bool releaseCues(Milliseconds until);
+  bool heldBefore(int a, int b);
+  void swapHeld(int a, int b);
 
   ParseState collectTimingsAndSettings(const String &line);
 
@@ -119,6 +164,17 @@ private:
   Timestamp currentStartTime;
   Timestamp currentEndTime;
   List<Cue> currentCues;
+
+  // Cues held for reordering, in a binary min-heap ordered by start time
+  // and then by 'heldOrder', the order they were parsed in
+  List<Cue> heldCues;
+  List<Milliseconds> heldStarts;
+  List<int> heldOrder;
+  int nextOrder;
+  Milliseconds windowSize;
+  Milliseconds latestStart;
+  Milliseconds lastEmitted;
+  int numLateCues;
 };
 
 } // TimedText
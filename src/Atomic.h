@@ -52,6 +52,19 @@
 #  include <atomic_ops.h>
 #  define USE_LIBATOMIC_OPS_ATOMIC
 #endif
+// Without any of the above, use the compiler's atomic builtins, unless
+// USE_NON_ATOMIC is defined. That is only safe if objects are never shared
+// between threads, but avoids locked instructions for every reference
+// count change.
+#if !defined(USE_NON_ATOMIC)
+#  if defined(__clang__) || (defined(__GNUC__) && \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#    define USE_GNUC_ATOMIC
+#  elif defined(_MSC_VER)
+#    include <intrin.h>
+#    define USE_MSVC_ATOMIC
+#  endif
+#endif
 
 namespace TimedText
 {
@@ -133,18 +146,68 @@ public:
 #define HAVE_ATOMIC
 #endif
 
-#if !defined(HAVE_ATOMIC)
-// implement non-atomic version here, for convenience
+#if !defined(HAVE_ATOMIC) && defined(USE_GNUC_ATOMIC)
+// Using GCC/Clang __atomic builtins
+class AtomicInt
+{
+public:
+  int value;
+  // Non-atomic ops:
+  AtomicInt() : value(0) {}
+  AtomicInt(int val) : value(val) {}
+  operator int() const { return __atomic_load_n(&value, __ATOMIC_ACQUIRE); }
+
+  // Atomic ops:
+  bool ref() {
+    // Taking a new reference needs no ordering, as the caller already holds
+    // one.
+    return __atomic_add_fetch(&value, 1, __ATOMIC_RELAXED) != 0;
+  }
+
+  bool deref() {
+    // Whoever releases the last reference must see all writes made through
+    // the others before freeing the data.
+    return __atomic_sub_fetch(&value, 1, __ATOMIC_ACQ_REL) != 0;
+  }
+};
+#define HAVE_ATOMIC
+#endif
+
+#if !defined(HAVE_ATOMIC) && defined(USE_MSVC_ATOMIC)
+// Using MSVC interlocked intrinsics
 class AtomicInt
 {
 public:
-  volatile int value;
+  volatile long value;
+  // Non-atomic ops:
   AtomicInt() : value(0) {}
   AtomicInt(int val) : value(val) {}
   operator int() const { return int(value); }
 
+  // Atomic ops:
+  bool ref() {
+    return _InterlockedIncrement(&value) != 0;
+  }
+
+  bool deref() {
+    return _InterlockedDecrement(&value) != 0;
+  }
+};
+#define HAVE_ATOMIC
+#endif
+
+#if !defined(HAVE_ATOMIC)
+// Non-atomic version, for USE_NON_ATOMIC builds and compilers without
+// atomic builtins.
+class AtomicInt
+{
+public:
+  int value;
+  AtomicInt() : value(0) {}
+  AtomicInt(int val) : value(val) {}
+  operator int() const { return value; }
+
   bool ref() {
-    // Atomically increment self
     return ++value != 0;
   }
 
@@ -154,6 +217,30 @@ public:
 };
 #endif
 
+// Relaxed load and store of a word which threads may race to fill in with
+// the same value, such as a cached hash. They order nothing else, but keep
+// the access itself from tearing. MSVC makes aligned volatile accesses of a
+// word atomic, and builds without atomics have no races to care about.
+template <typename T>
+inline T atomicLoadRelaxed(const T *p)
+{
+#if defined(USE_GNUC_ATOMIC)
+  return __atomic_load_n(p, __ATOMIC_RELAXED);
+#else
+  return *static_cast<const volatile T *>(p);
+#endif
+}
+
+template <typename T>
+inline void atomicStoreRelaxed(T *p, T value)
+{
+#if defined(USE_GNUC_ATOMIC)
+  __atomic_store_n(p, value, __ATOMIC_RELAXED);
+#else
+  *static_cast<volatile T *>(p) = value;
+#endif
+}
+
 } // TimedText
 
 #endif // __TimedText_Atomic__
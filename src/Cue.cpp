@@ -38,6 +38,14 @@ public:
   EmptyCueData() : CueData(EmptyCue) {}
 } emptyCue;
 
+// Moved-from handles are left referring to the empty cue
+CueData *
+Cue::sharedEmpty()
+{
+  emptyCue.ref.ref();
+  return &emptyCue;
+}
+
 Cue::Cue(CueType type) : d(0)
 {
   if(type == WebVTTCue)
@@ -55,6 +63,7 @@ Cue::Cue(CueType type) : d(0)
 
 Cue::Cue(CueType type, Timestamp startTime, Timestamp endTime,
          const String &id, const String &text)
+  : d(0)
 {
   if(type == WebVTTCue)
     d = new WebVTTCueData(startTime, endTime, id, text);
@@ -267,7 +276,7 @@ Cue::setNodes(const Node &nodes)
 }
 
 void
-Cue::visit(NodeVisitor &visitor)
+Cue::visit(NodeVisitor &visitor) const
 {
   Node tree;
   if(nodes(tree))
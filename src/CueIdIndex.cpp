@@ -0,0 +1,179 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/CueIdIndex.h>
+#include "HashChains.h"
+#include <climits>
+#include <cstdlib>
+
+namespace TimedText
+{
+
+struct CueIdIndex::Entry
+{
+  uint32 hash;
+  // Next entry in the same bucket, or -1
+  int next;
+  // First and last cues with this id
+  int first;
+  int last;
+};
+
+CueIdIndex::CueIdIndex()
+  : entries(0), numEntries(0), entryAlloc(0), buckets(0), numBuckets(0)
+{
+}
+
+CueIdIndex::CueIdIndex(const List<Cue> &cues)
+  : entries(0), numEntries(0), entryAlloc(0), buckets(0), numBuckets(0)
+{
+  insert(cues);
+}
+
+CueIdIndex::~CueIdIndex()
+{
+  clear();
+}
+
+bool
+CueIdIndex::insert(const Cue &cue)
+{
+  String id = cue.id();
+  bool hasId = !id.isEmpty();
+  uint32 hash = hasId ? id.hash() : 0;
+  int e = hasId ? findEntry(id, hash) : -1;
+  bool newId = hasId && e < 0;
+  if(newId) {
+    if(numEntries == entryAlloc) {
+      if(entryAlloc > INT_MAX / int(2 * sizeof(Entry)))
+        return false;
+      int alloc = entryAlloc ? entryAlloc * 2 : 16;
+      Entry *x = static_cast<Entry *>(
+        ::realloc(entries, alloc * sizeof(Entry)));
+      if(!x)
+        return false;
+      entries = x;
+      entryAlloc = alloc;
+    }
+    if(!reserveBuckets(buckets, numBuckets, numEntries, 16,
+                       HashEntryArray<Entry>(entries)))
+      return false;
+  }
+
+  int i = cues.count();
+  if(!cues.push(cue))
+    return false;
+  if(!nextSame.push(-1)) {
+    cues.pop();
+    return false;
+  }
+  if(newId && !ids.push(id)) {
+    cues.pop();
+    nextSame.pop();
+    return false;
+  }
+  if(!hasId)
+    return true;
+
+  if(newId) {
+    e = numEntries++;
+    Entry &entry = entries[e];
+    entry.hash = hash;
+    entry.first = i;
+    linkEntry(buckets, numBuckets, e, HashEntryArray<Entry>(entries));
+  } else {
+    nextSame[entries[e].last] = i;
+  }
+  entries[e].last = i;
+  return true;
+}
+
+bool
+CueIdIndex::insert(const List<Cue> &list)
+{
+  for(List<Cue>::const_iterator it = list.begin(); it != list.end(); ++it) {
+    if(!insert(*it))
+      return false;
+  }
+  return true;
+}
+
+void
+CueIdIndex::clear()
+{
+  cues.clear();
+  nextSame.clear();
+  ids.clear();
+  ::free(entries);
+  ::free(buckets);
+  entries = 0;
+  numEntries = entryAlloc = 0;
+  buckets = 0;
+  numBuckets = 0;
+}
+
+int
+CueIdIndex::indexOf(const String &id) const
+{
+  if(id.isEmpty())
+    return -1;
+  int e = findEntry(id, id.hash());
+  return e < 0 ? -1 : entries[e].first;
+}
+
+bool
+CueIdIndex::find(const String &id, Cue &result) const
+{
+  int i = indexOf(id);
+  return i >= 0 && cues.itemAt(i, result);
+}
+
+bool
+CueIdIndex::findAll(const String &id, List<Cue> &result) const
+{
+  for(int i = indexOf(id); i >= 0; i = nextSame.begin()[i]) {
+    if(!result.push(cueAt(i)))
+      return false;
+  }
+  return true;
+}
+
+int
+CueIdIndex::findEntry(const String &id, uint32 hash) const
+{
+  if(!numBuckets)
+    return -1;
+  List<String>::const_iterator keys = ids.begin();
+  for(int e = hashBucket(buckets, numBuckets, hash); e >= 0;
+      e = entries[e].next) {
+    if(entries[e].hash == hash && keys[e] == id)
+      return e;
+  }
+  return -1;
+}
+
+} // TimedText
@@ -0,0 +1,257 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/CueScheduler.h>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+namespace TimedText
+{
+
+struct CueScheduler::Event
+{
+  // Start time in 'starts' and end time in 'ends', with the other in 'other'
+  Milliseconds time;
+  Milliseconds other;
+};
+
+CueScheduler::CueScheduler()
+  : starts(0), ends(0), alloc(0), nextStart(0), nextEnd(0),
+    now(MalformedTimestamp)
+{
+}
+
+CueScheduler::CueScheduler(const List<Cue> &list)
+  : starts(0), ends(0), alloc(0), nextStart(0), nextEnd(0),
+    now(MalformedTimestamp)
+{
+  insert(list);
+}
+
+CueScheduler::~CueScheduler()
+{
+  ::free(starts);
+  ::free(ends);
+}
+
+bool
+CueScheduler::insert(const Cue &cue)
+{
+  Timestamp start = cue.startTime();
+  Timestamp end = cue.endTime();
+  if(start.isMalformed() || end.isMalformed()
+     || Milliseconds(end) < Milliseconds(start))
+    return false;
+  if(count() == alloc && !grow())
+    return false;
+  if(!timeline.insert(cue)
+     || !insertEvent(starts, startCues, start, end, cue)
+     || !insertEvent(ends, endCues, end, start, cue))
+    return false;
+
+  if(Milliseconds(start) <= now) {
+    ++nextStart;
+    if(Milliseconds(end) <= now)
+      ++nextEnd;
+    else if(!insertActive(cue) || !pending.push(cue))
+      return false;
+  }
+  return true;
+}
+
+bool
+CueScheduler::insert(const List<Cue> &list)
+{
+  bool result = true;
+  Cue cue;
+  for(int i = 0; i < list.count(); ++i) {
+    if(list.itemAt(i, cue) && !insert(cue))
+      result = false;
+  }
+  return result;
+}
+
+void
+CueScheduler::clear()
+{
+  timeline.clear();
+  ::free(starts);
+  ::free(ends);
+  starts = ends = 0;
+  alloc = 0;
+  startCues.clear();
+  endCues.clear();
+  nextStart = nextEnd = 0;
+  now = MalformedTimestamp;
+  active.clear();
+  pending.clear();
+}
+
+bool
+CueScheduler::update(Timestamp time, List<Cue> &entered, List<Cue> &exited)
+{
+  if(time.isMalformed())
+    return false;
+  Milliseconds t = time;
+  if(t < now)
+    return seek(time, entered, exited);
+
+  Cue cue;
+  while(pending.shift(cue)) {
+    if(!entered.push(cue))
+      return false;
+  }
+
+  int n = count();
+  for(; nextStart < n && starts[nextStart].time <= t; ++nextStart) {
+    startCues.itemAt(nextStart, cue);
+    if(!entered.push(cue))
+      return false;
+    // Missed cues are only reported as exiting, below
+    if(starts[nextStart].other > t && !active.push(cue))
+      return false;
+  }
+
+  for(; nextEnd < n && ends[nextEnd].time <= t; ++nextEnd) {
+    endCues.itemAt(nextEnd, cue);
+    if(!exited.push(cue))
+      return false;
+    if(ends[nextEnd].other <= now) {
+      for(int i = 0; i < active.count(); ++i) {
+        if(active[i] == cue) {
+          active.take(i, cue);
+          break;
+        }
+      }
+    }
+  }
+
+  now = t;
+  return true;
+}
+
+bool
+CueScheduler::seek(Timestamp time, List<Cue> &entered, List<Cue> &exited)
+{
+  if(time.isMalformed())
+    return false;
+  Milliseconds t = time;
+  List<Cue> current;
+  if(!timeline.activeCues(time, current))
+    return false;
+
+  // Cues inserted while active were never reported as entered, so they are
+  // not reported as exiting either
+  Cue cue;
+  while(pending.shift(cue)) {
+    for(int i = 0; i < active.count(); ++i) {
+      if(active[i] == cue) {
+        active.take(i, cue);
+        break;
+      }
+    }
+  }
+
+  for(int i = 0; i < active.count(); ++i) {
+    if(!current.contains(active[i]) && !exited.push(active[i]))
+      return false;
+  }
+  for(int i = 0; i < current.count(); ++i) {
+    if(!active.contains(current[i]) && !entered.push(current[i]))
+      return false;
+  }
+
+  nextStart = findAfter(starts, count(), t);
+  nextEnd = findAfter(ends, count(), t);
+  active = current;
+  now = t;
+  return true;
+}
+
+bool
+CueScheduler::grow()
+{
+  if(alloc > INT_MAX / 2)
+    return false;
+  int size = alloc ? alloc * 2 : 16;
+  Event *s = static_cast<Event *>(::realloc(starts, size * sizeof(Event)));
+  if(!s)
+    return false;
+  starts = s;
+  Event *e = static_cast<Event *>(::realloc(ends, size * sizeof(Event)));
+  if(!e)
+    return false;
+  ends = e;
+  alloc = size;
+  return true;
+}
+
+bool
+CueScheduler::insertEvent(Event *events, List<Cue> &cues, Milliseconds time,
+                          Milliseconds other, const Cue &cue)
+{
+  int n = cues.count();
+  int i = findAfter(events, n, time);
+  if(!cues.insert(i, cue))
+    return false;
+  ::memmove(events + i + 1, events + i, (n - i) * sizeof(Event));
+  events[i].time = time;
+  events[i].other = other;
+  return true;
+}
+
+bool
+CueScheduler::insertActive(const Cue &cue)
+{
+  // Keep the active cues in order of start time
+  int i = active.count();
+  while(i > 0 && active[i - 1].startTime() > cue.startTime())
+    --i;
+  return active.insert(i, cue);
+}
+
+// Index of the first event later than 'time'
+int
+CueScheduler::findAfter(const Event *events, int count, Milliseconds time)
+{
+  // Cues are usually inserted in order, and playback usually begins from
+  // the start
+  if(!count || events[count - 1].time <= time)
+    return count;
+  int lo = 0, hi = count;
+  while(lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if(events[mid].time <= time)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+} // TimedText
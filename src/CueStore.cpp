@@ -0,0 +1,229 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/CueStore.h>
+#include <TimedText/TimeTransform.h>
+#include "PackedCueSettings.h"
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+namespace TimedText
+{
+
+CueStore::CueStore()
+  : numCues(0), alloc(0), starts(0), ends(0), settings(0), offsets(0),
+    buffer(0), textLength(0), textAlloc(0)
+{
+}
+
+CueStore::~CueStore()
+{
+  clear();
+}
+
+bool
+CueStore::append(const Cue &cue)
+{
+  if(numCues == alloc && !grow())
+    return false;
+  int mark = textLength;
+  String id = cue.id();
+  String text = cue.text();
+  if(!appendText(id))
+    return false;
+  int idEnd = textLength;
+  if(!appendText(text)) {
+    textLength = mark;
+    return false;
+  }
+
+  int i = numCues++;
+  starts[i] = cue.startTime();
+  ends[i] = cue.endTime();
+  offsets[2 * i + 1] = idEnd;
+  offsets[2 * i + 2] = textLength;
+
+  PackedCueSettings &s = settings[i];
+  s.pack(cue);
+  if(id.isNull())
+    s.flags |= PackedCueSettings::NullIdFlag;
+  if(text.isNull())
+    s.flags |= PackedCueSettings::NullTextFlag;
+  return true;
+}
+
+bool
+CueStore::append(const List<Cue> &list)
+{
+  Cue cue;
+  for(int i = 0; i < list.count(); ++i) {
+    if(!list.itemAt(i, cue) || !append(cue))
+      return false;
+  }
+  return true;
+}
+
+void
+CueStore::clear()
+{
+  ::free(starts);
+  ::free(ends);
+  ::free(settings);
+  ::free(offsets);
+  ::free(buffer);
+  starts = ends = 0;
+  settings = 0;
+  offsets = 0;
+  buffer = 0;
+  numCues = alloc = 0;
+  textLength = textAlloc = 0;
+}
+
+String
+CueStore::id(int i) const
+{
+  if(settings[i].flags & PackedCueSettings::NullIdFlag)
+    return String();
+  // Stored text was taken from Strings, so it need not be checked again
+  return String::fromValidUtf8(buffer + offsets[2 * i],
+                               offsets[2 * i + 1] - offsets[2 * i]);
+}
+
+String
+CueStore::text(int i) const
+{
+  if(settings[i].flags & PackedCueSettings::NullTextFlag)
+    return String();
+  return String::fromValidUtf8(buffer + offsets[2 * i + 1],
+                               offsets[2 * i + 2] - offsets[2 * i + 1]);
+}
+
+bool
+CueStore::cueAt(int i, Cue &result) const
+{
+  if(i < 0 || i >= numCues)
+    return false;
+  const PackedCueSettings &s = settings[i];
+  Cue cue(CueType(s.type), startTime(i), endTime(i), id(i), text(i));
+  s.apply(cue);
+  result = cue;
+  return true;
+}
+
+bool
+CueStore::activeCues(Timestamp time, List<int> &result) const
+{
+  if(time.isMalformed())
+    return false;
+  Milliseconds t = time;
+  // Indices are written unconditionally and kept only when the cue is
+  // active, so the inner loop has no branches to mispredict and can be
+  // vectorized.
+  enum { BlockSize = 64 };
+  int found[BlockSize];
+  int i = 0;
+  while(i < numCues) {
+    int end = numCues - i > BlockSize ? i + BlockSize : numCues;
+    int n = 0;
+    for(; i < end; ++i) {
+      found[n] = i;
+      n += int(starts[i] <= t) & int(ends[i] > t);
+    }
+    for(int j = 0; j < n; ++j) {
+      if(!result.push(found[j]))
+        return false;
+    }
+  }
+  return true;
+}
+
+void
+CueStore::transform(const TimeTransform &transform)
+{
+  transform.apply(starts, numCues);
+  transform.apply(ends, numCues);
+}
+
+bool
+CueStore::grow()
+{
+  if(alloc > (INT_MAX - 1) / 4)
+    return false;
+  int size = alloc ? alloc * 2 : 64;
+  // Each column is replaced only once it has been successfully grown, so a
+  // failure leaves the store as it was.
+  Milliseconds *s = static_cast<Milliseconds *>(
+    ::realloc(starts, size * sizeof(Milliseconds)));
+  if(!s)
+    return false;
+  starts = s;
+  Milliseconds *e = static_cast<Milliseconds *>(
+    ::realloc(ends, size * sizeof(Milliseconds)));
+  if(!e)
+    return false;
+  ends = e;
+  PackedCueSettings *x = static_cast<PackedCueSettings *>(
+    ::realloc(settings, size * sizeof(PackedCueSettings)));
+  if(!x)
+    return false;
+  settings = x;
+  int *o = static_cast<int *>(::realloc(offsets,
+                                        (2 * size + 1) * sizeof(int)));
+  if(!o)
+    return false;
+  if(!offsets)
+    o[0] = 0;
+  offsets = o;
+  alloc = size;
+  return true;
+}
+
+bool
+CueStore::appendText(const String &str)
+{
+  int len = str.length();
+  if(!len)
+    return true;
+  if(len > INT_MAX - textLength)
+    return false;
+  if(textLength + len > textAlloc) {
+    int size = textAlloc ? textAlloc : 1024;
+    while(size < textLength + len)
+      size = size > INT_MAX / 2 ? INT_MAX : size * 2;
+    char *x = static_cast<char *>(::realloc(buffer, size));
+    if(!x)
+      return false;
+    buffer = x;
+    textAlloc = size;
+  }
+  ::memcpy(buffer + textLength, str.text(), len);
+  textLength += len;
+  return true;
+}
+
+} // TimedText
@@ -0,0 +1,762 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/CueTextIndex.h>
+#include <TimedText/StringBuilder.h>
+#include <TimedText/Unicode.h>
+#include <TimedText/WebVTTParser.h>
+#include "HashChains.h"
+#include "Utility.h"
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+namespace TimedText
+{
+
+static const char indexMagic[4] = { 'T', 'T', 'I', 'X' };
+static const uint32 indexByteOrder = 0x01020304;
+
+// Occurrence of a word: the cue it is in, and how many words precede it
+// in that cue. Postings of each word are in increasing order.
+struct TextPosting
+{
+  int32 cue;
+  int32 position;
+};
+
+struct TextWord
+{
+  char text[CueTextIndex::MaxWordLength];
+  int length;
+};
+
+struct TextTerm
+{
+  uint32 hash;
+  // Next term in the same hash bucket, or -1
+  int next;
+  // Text, in CueTextIndex::chars
+  int offset;
+  int length;
+  TextPosting *postings;
+  int count;
+  int alloc;
+};
+
+// All offsets are in bytes, from the start of the image, except for those
+// into the text area.
+struct CueTextIndex::Header
+{
+  char magic[4];
+  uint32 version;
+  uint32 byteOrder;
+  uint32 size;
+  uint32 count;
+  uint32 termCount;
+  // Milliseconds[count]
+  uint32 starts;
+  uint32 ends;
+  // TermRecord[termCount], in the order of their text
+  uint32 terms;
+  // TextPosting[postingCount]
+  uint32 postings;
+  uint32 postingCount;
+  uint32 text;
+  uint32 textSize;
+  // Pads the header to a multiple of 8 bytes
+  uint32 reserved;
+};
+
+struct CueTextIndex::TermRecord
+{
+  // Text, in the text area
+  uint32 offset;
+  uint32 length;
+  // Postings, as an index and count into the posting area
+  uint32 first;
+  uint32 count;
+};
+
+// Fold the case of letters of the scripts listed in CueTextIndex.h, as
+// Unicode simple case folding does
+static uint32
+foldCase(uint32 c)
+{
+  if(c < 0x80)
+    return Char::isAsciiUppercase(c) ? c + 0x20 : c;
+  if((c >= 0xC0 && c <= 0xDE && c != 0xD7)
+     || (c >= 0x391 && c <= 0x3AB && c != 0x3A2)
+     || (c >= 0x410 && c <= 0x42F))
+    return c + 0x20;
+  if(c == 0x3C2)
+    return 0x3C3;
+  if(c >= 0x400 && c <= 0x40F)
+    return c + 0x50;
+  return c;
+}
+
+// Words are runs of letters and digits. Outside of ASCII, anything but
+// Latin-1 symbols, the general and CJK punctuation blocks, and specials
+// (including the replacement character) is taken to be a letter.
+static bool
+isWordChar(uint32 c)
+{
+  if(c < 0x80)
+    return Char::isAsciiAlphanumeric(c);
+  if(c < 0xC0)
+    return c == 0xAA || c == 0xB5 || c == 0xBA;
+  return c != 0xD7 && c != 0xF7
+    && !(c >= 0x2000 && c <= 0x206F)
+    && !(c >= 0x3000 && c <= 0x303F)
+    && c != 0xFEFF && c < 0xFFF0;
+}
+
+// Read the next word of 'text' from 'position' into 'word', with its case
+// folded. Characters which do not fit are dropped. Returns false if there
+// are no more words.
+static bool
+nextWord(const char *text, int len, int &position, TextWord &word)
+{
+  word.length = 0;
+  while(position < len) {
+    uint32 c = Unicode::utf8ToUCS4(text, len, position);
+    if(!isWordChar(c)) {
+      if(word.length)
+        return true;
+      continue;
+    }
+    c = foldCase(c);
+    char buf[4];
+    int n = 1;
+    if(c < 0x80)
+      buf[0] = char(c);
+    else
+      Unicode::toUtf8(c, buf, n);
+    if(word.length + n <= int(CueTextIndex::MaxWordLength)) {
+      ::memcpy(word.text + word.length, buf, n);
+      word.length += n;
+    }
+  }
+  return word.length > 0;
+}
+
+static inline int
+compareText(const char *a, int alen, const char *b, int blen)
+{
+  int r = ::memcmp(a, b, alen < blen ? alen : blen);
+  return r ? r : alen - blen;
+}
+
+static inline bool
+termLess(const TextTerm *terms, const char *chars, int a, int b)
+{
+  return compareText(chars + terms[a].offset, terms[a].length,
+                     chars + terms[b].offset, terms[b].length) < 0;
+}
+
+static void
+siftDown(int *ids, int root, int n, const TextTerm *terms, const char *chars)
+{
+  for(;;) {
+    int child = 2 * root + 1;
+    if(child >= n)
+      break;
+    if(child + 1 < n && termLess(terms, chars, ids[child], ids[child + 1]))
+      ++child;
+    if(!termLess(terms, chars, ids[root], ids[child]))
+      break;
+    int t = ids[root];
+    ids[root] = ids[child];
+    ids[child] = t;
+    root = child;
+  }
+}
+
+// Heap sort, which needs no extra memory
+static void
+sortTermIds(int *ids, int n, const TextTerm *terms, const char *chars)
+{
+  for(int i = n / 2 - 1; i >= 0; --i)
+    siftDown(ids, i, n, terms, chars);
+  for(int end = n - 1; end > 0; --end) {
+    int t = ids[0];
+    ids[0] = ids[end];
+    ids[end] = t;
+    siftDown(ids, 0, end, terms, chars);
+  }
+}
+
+// Append the distinct cues of 'postings' to 'result'
+static bool
+appendCues(const TextPosting *postings, int n, List<int> &result)
+{
+  int last = -1;
+  for(int i = 0; i < n; ++i) {
+    if(postings[i].cue != last) {
+      last = postings[i].cue;
+      if(!result.push(last))
+        return false;
+    }
+  }
+  return true;
+}
+
+static bool
+hasPosting(const TextPosting *postings, int n, int32 cue, int32 position)
+{
+  int lo = 0;
+  int hi = n;
+  while(lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    const TextPosting &p = postings[mid];
+    if(p.cue < cue || (p.cue == cue && p.position < position))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo < n && postings[lo].cue == cue && postings[lo].position == position;
+}
+
+static bool
+visibleText(const Cue &cue, StringBuilder &result)
+{
+  if(cue.type() == WebVTTCue)
+    return WebVTTParser::cuetextToPlainText(cue.text(), result);
+  return result.append(cue.text());
+}
+
+CueTextIndex::CueTextIndex()
+  : numCues(0), cueAlloc(0), starts(0), ends(0), startColumn(0),
+    endColumn(0), terms(0), numTerms(0), termAlloc(0), buckets(0),
+    numBuckets(0), chars(0), numChars(0), charAlloc(0), sorted(0),
+    numSorted(0), header(0), base(0)
+{
+}
+
+CueTextIndex::~CueTextIndex()
+{
+  clear();
+}
+
+bool
+CueTextIndex::add(const Cue &cue)
+{
+  if(header)
+    return false;
+  if(numCues == cueAlloc && !growCues())
+    return false;
+  StringBuilder text;
+  if(!visibleText(cue, text))
+    return false;
+  const char *s = text.text();
+  int len = text.length();
+  int at = 0;
+  int position = 0;
+  TextWord word;
+  bool ok = true;
+  while(ok && nextWord(s, len, at, word)) {
+    uint32 hash = hashBytes(word.text, word.length);
+    int term = findTerm(word, hash);
+    if(term < 0)
+      term = addTerm(word, hash);
+    ok = term >= 0 && addPosting(term, position++);
+  }
+  if(!ok) {
+    // Take back the postings already added for this cue, which are the
+    // last of their terms
+    for(int i = 0; i < numTerms; ++i) {
+      TextTerm &t = terms[i];
+      while(t.count > 0 && t.postings[t.count - 1].cue == numCues)
+        --t.count;
+    }
+    return false;
+  }
+  starts[numCues] = cue.startTime();
+  ends[numCues] = cue.endTime();
+  ++numCues;
+  return true;
+}
+
+bool
+CueTextIndex::add(const List<Cue> &cues)
+{
+  for(List<Cue>::const_iterator it = cues.begin(); it != cues.end(); ++it) {
+    if(!add(*it))
+      return false;
+  }
+  return true;
+}
+
+void
+CueTextIndex::clear()
+{
+  for(int i = 0; i < numTerms; ++i)
+    ::free(terms[i].postings);
+  ::free(starts);
+  ::free(ends);
+  ::free(terms);
+  ::free(buckets);
+  ::free(chars);
+  ::free(sorted);
+  numCues = cueAlloc = 0;
+  starts = ends = 0;
+  startColumn = endColumn = 0;
+  terms = 0;
+  numTerms = termAlloc = 0;
+  buckets = 0;
+  numBuckets = 0;
+  chars = 0;
+  numChars = charAlloc = 0;
+  sorted = 0;
+  numSorted = 0;
+  header = 0;
+  base = 0;
+}
+
+int
+CueTextIndex::wordCount() const
+{
+  return header ? int(header->termCount) : numTerms;
+}
+
+bool
+CueTextIndex::find(const String &word, List<int> &result) const
+{
+  TextWord w;
+  int at = 0;
+  if(!nextWord(word.text(), word.length(), at, w))
+    return true;
+  const TextPosting *postings;
+  int n;
+  if(!lookup(w, postings, n))
+    return true;
+  return appendCues(postings, n, result);
+}
+
+bool
+CueTextIndex::findPrefix(const String &prefix, List<int> &result) const
+{
+  TextWord w;
+  int at = 0;
+  if(!nextWord(prefix.text(), prefix.length(), at, w))
+    return true;
+  int total = sortTerms();
+  // First term not less than the prefix
+  int lo = 0;
+  int hi = total;
+  while(lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    const char *text;
+    int len;
+    const TextPosting *postings;
+    int n;
+    sortedTerm(mid, text, len, postings, n);
+    if(compareText(text, len, w.text, w.length) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  // Several terms may match in the same cue, so matches are marked in a
+  // bitmap, which is then read in order
+  int words = (numCues + 31) / 32;
+  uint32 *marks = static_cast<uint32 *>(::calloc(words ? words : 1,
+                                                 sizeof(uint32)));
+  if(!marks)
+    return false;
+  for(int rank = lo; rank < total; ++rank) {
+    const char *text;
+    int len;
+    const TextPosting *postings;
+    int n;
+    sortedTerm(rank, text, len, postings, n);
+    if(len < w.length || ::memcmp(text, w.text, w.length))
+      break;
+    for(int i = 0; i < n; ++i)
+      marks[postings[i].cue >> 5] |= uint32(1) << (postings[i].cue & 31);
+  }
+  bool ok = true;
+  for(int i = 0; ok && i < words; ++i) {
+    uint32 mask = marks[i];
+    while(ok && mask) {
+      ok = result.push(i * 32 + countTrailingZeros(mask));
+      mask &= mask - 1;
+    }
+  }
+  ::free(marks);
+  return ok;
+}
+
+bool
+CueTextIndex::findPhrase(const String &phrase, List<int> &result) const
+{
+  List<const TextPosting *> spans;
+  List<int> counts;
+  TextWord w;
+  int at = 0;
+  while(nextWord(phrase.text(), phrase.length(), at, w)) {
+    const TextPosting *postings;
+    int n;
+    if(!lookup(w, postings, n))
+      return true;
+    if(!spans.push(postings) || !counts.push(n))
+      return false;
+  }
+  if(spans.isEmpty())
+    return true;
+  // Each occurrence of the first word starts a match if the others follow
+  // it in the same cue
+  const TextPosting *first = spans[0];
+  int n = counts[0];
+  int last = -1;
+  for(int i = 0; i < n; ++i) {
+    const TextPosting &p = first[i];
+    if(p.cue == last)
+      continue;
+    int j = 1;
+    while(j < spans.count()
+          && hasPosting(spans[j], counts[j], p.cue, p.position + j))
+      ++j;
+    if(j == spans.count()) {
+      last = p.cue;
+      if(!result.push(last))
+        return false;
+    }
+  }
+  return true;
+}
+
+int
+CueTextIndex::imageSize() const
+{
+  if(header)
+    return int(header->size);
+  uint64 postings = 0;
+  for(int i = 0; i < numTerms; ++i)
+    postings += terms[i].count;
+  uint64 size = sizeof(Header) + uint64(numCues) * 2 * sizeof(Milliseconds)
+    + uint64(numTerms) * sizeof(TermRecord)
+    + postings * sizeof(TextPosting) + numChars;
+  return size > uint64(INT_MAX) ? 0 : int(size);
+}
+
+bool
+CueTextIndex::writeImage(void *data, int size) const
+{
+  int needed = imageSize();
+  if(!data || !needed || size < needed || (uintptr(data) & 7))
+    return false;
+  if(header) {
+    ::memcpy(data, base, needed);
+    return true;
+  }
+  int total = sortTerms();
+  char *out = static_cast<char *>(data);
+  Header *h = reinterpret_cast<Header *>(out);
+  ::memset(h, 0, sizeof(Header));
+  ::memcpy(h->magic, indexMagic, sizeof(indexMagic));
+  h->version = Version;
+  h->byteOrder = indexByteOrder;
+  h->size = uint32(needed);
+  h->count = uint32(numCues);
+  h->termCount = uint32(total);
+  h->starts = sizeof(Header);
+  h->ends = h->starts + uint32(numCues * sizeof(Milliseconds));
+  h->terms = h->ends + uint32(numCues * sizeof(Milliseconds));
+  h->postings = h->terms + uint32(total * sizeof(TermRecord));
+  ::memcpy(out + h->starts, starts, numCues * sizeof(Milliseconds));
+  ::memcpy(out + h->ends, ends, numCues * sizeof(Milliseconds));
+
+  // Terms are written in order, with their postings and text following
+  // in the same order
+  TermRecord *records = reinterpret_cast<TermRecord *>(out + h->terms);
+  TextPosting *postings = reinterpret_cast<TextPosting *>(out + h->postings);
+  uint32 first = 0;
+  for(int rank = 0; rank < total; ++rank) {
+    const TextTerm &t = terms[sorted[rank]];
+    records[rank].first = first;
+    records[rank].count = uint32(t.count);
+    ::memcpy(postings + first, t.postings, t.count * sizeof(TextPosting));
+    first += uint32(t.count);
+  }
+  h->postingCount = first;
+  h->text = h->postings + uint32(first * sizeof(TextPosting));
+  h->textSize = uint32(numChars);
+  char *text = out + h->text;
+  uint32 offset = 0;
+  for(int rank = 0; rank < total; ++rank) {
+    const TextTerm &t = terms[sorted[rank]];
+    records[rank].offset = offset;
+    records[rank].length = uint32(t.length);
+    ::memcpy(text + offset, chars + t.offset, t.length);
+    offset += uint32(t.length);
+  }
+  return true;
+}
+
+static inline bool
+validSection(uint32 offset, uint64 length, uint32 align, uint32 size)
+{
+  return !(offset & (align - 1)) && offset + length <= uint64(size);
+}
+
+bool
+CueTextIndex::open(const void *data, int size)
+{
+  clear();
+  if(!data || size < int(sizeof(Header)) || (uintptr(data) & 7))
+    return false;
+  const Header *h = static_cast<const Header *>(data);
+  if(::memcmp(h->magic, indexMagic, sizeof(indexMagic))
+     || h->version != Version || h->byteOrder != indexByteOrder
+     || h->size > uint32(size) || h->size < sizeof(Header)
+     || h->count > uint32(INT_MAX) || h->termCount > uint32(INT_MAX)
+     || h->postingCount > uint32(INT_MAX))
+    return false;
+  uint64 n = h->count;
+  if(!validSection(h->starts, n * sizeof(Milliseconds), 8, h->size)
+     || !validSection(h->ends, n * sizeof(Milliseconds), 8, h->size)
+     || !validSection(h->terms, uint64(h->termCount) * sizeof(TermRecord), 4,
+                      h->size)
+     || !validSection(h->postings,
+                      uint64(h->postingCount) * sizeof(TextPosting), 4,
+                      h->size)
+     || !validSection(h->text, h->textSize, 1, h->size))
+    return false;
+  // Queries trust the records and postings, so they are checked once here
+  const char *p = static_cast<const char *>(data);
+  const TermRecord *records =
+    reinterpret_cast<const TermRecord *>(p + h->terms);
+  for(uint32 i = 0; i < h->termCount; ++i) {
+    const TermRecord &r = records[i];
+    if(uint64(r.offset) + r.length > h->textSize
+       || uint64(r.first) + r.count > h->postingCount)
+      return false;
+  }
+  const TextPosting *postings =
+    reinterpret_cast<const TextPosting *>(p + h->postings);
+  for(uint32 i = 0; i < h->postingCount; ++i) {
+    if(postings[i].cue < 0 || uint32(postings[i].cue) >= h->count)
+      return false;
+  }
+  header = h;
+  base = p;
+  numCues = int(h->count);
+  startColumn = reinterpret_cast<const Milliseconds *>(p + h->starts);
+  endColumn = reinterpret_cast<const Milliseconds *>(p + h->ends);
+  return true;
+}
+
+bool
+CueTextIndex::lookup(const TextWord &word, const TextPosting *&postings,
+                     int &n) const
+{
+  if(!header) {
+    int term = findTerm(word, hashBytes(word.text, word.length));
+    if(term < 0)
+      return false;
+    postings = terms[term].postings;
+    n = terms[term].count;
+    return n > 0;
+  }
+  int lo = 0;
+  int hi = int(header->termCount);
+  while(lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    const char *text;
+    int len;
+    sortedTerm(mid, text, len, postings, n);
+    int r = compareText(text, len, word.text, word.length);
+    if(!r)
+      return n > 0;
+    if(r < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return false;
+}
+
+int
+CueTextIndex::sortTerms() const
+{
+  if(header)
+    return int(header->termCount);
+  if(numSorted == numTerms)
+    return numTerms;
+  // Sort the new terms, then merge them with the old ones through the
+  // second half of 'sorted'
+  int added = numTerms - numSorted;
+  int *fresh = sorted + numSorted;
+  for(int i = 0; i < added; ++i)
+    fresh[i] = numSorted + i;
+  sortTermIds(fresh, added, terms, chars);
+  int *merged = sorted + termAlloc;
+  int a = 0;
+  int b = 0;
+  int k = 0;
+  while(a < numSorted && b < added) {
+    if(termLess(terms, chars, fresh[b], sorted[a]))
+      merged[k++] = fresh[b++];
+    else
+      merged[k++] = sorted[a++];
+  }
+  while(a < numSorted)
+    merged[k++] = sorted[a++];
+  while(b < added)
+    merged[k++] = fresh[b++];
+  ::memcpy(sorted, merged, numTerms * sizeof(int));
+  numSorted = numTerms;
+  return numTerms;
+}
+
+void
+CueTextIndex::sortedTerm(int rank, const char *&text, int &len,
+                         const TextPosting *&postings, int &n) const
+{
+  if(header) {
+    const TermRecord &r =
+      reinterpret_cast<const TermRecord *>(base + header->terms)[rank];
+    text = base + header->text + r.offset;
+    len = int(r.length);
+    postings =
+      reinterpret_cast<const TextPosting *>(base + header->postings) + r.first;
+    n = int(r.count);
+  } else {
+    const TextTerm &t = terms[sorted[rank]];
+    text = chars + t.offset;
+    len = t.length;
+    postings = t.postings;
+    n = t.count;
+  }
+}
+
+int
+CueTextIndex::findTerm(const TextWord &word, uint32 hash) const
+{
+  if(!numBuckets)
+    return -1;
+  for(int i = hashBucket(buckets, numBuckets, hash); i >= 0;
+      i = terms[i].next) {
+    const TextTerm &t = terms[i];
+    if(t.hash == hash && t.length == word.length
+       && !::memcmp(chars + t.offset, word.text, word.length))
+      return i;
+  }
+  return -1;
+}
+
+int
+CueTextIndex::addTerm(const TextWord &word, uint32 hash)
+{
+  if(numTerms == termAlloc) {
+    if(termAlloc > INT_MAX / 4)
+      return -1;
+    int alloc = termAlloc ? termAlloc * 2 : 64;
+    TextTerm *t = static_cast<TextTerm *>(
+      ::realloc(terms, alloc * sizeof(TextTerm)));
+    if(!t)
+      return -1;
+    terms = t;
+    int *s = static_cast<int *>(::realloc(sorted, 2 * alloc * sizeof(int)));
+    if(!s)
+      return -1;
+    sorted = s;
+    termAlloc = alloc;
+  }
+  if(!reserveBuckets(buckets, numBuckets, numTerms, 64,
+                     HashEntryArray<TextTerm>(terms)))
+    return -1;
+  if(charAlloc - numChars < word.length) {
+    if(charAlloc > INT_MAX / 2)
+      return -1;
+    // Words are never longer than MaxWordLength, so doubling is enough
+    int alloc = charAlloc ? charAlloc * 2 : 256;
+    char *c = static_cast<char *>(::realloc(chars, alloc));
+    if(!c)
+      return -1;
+    chars = c;
+    charAlloc = alloc;
+  }
+  int i = numTerms++;
+  TextTerm &t = terms[i];
+  t.hash = hash;
+  t.offset = numChars;
+  t.length = word.length;
+  t.postings = 0;
+  t.count = 0;
+  t.alloc = 0;
+  ::memcpy(chars + numChars, word.text, word.length);
+  numChars += word.length;
+  linkEntry(buckets, numBuckets, i, HashEntryArray<TextTerm>(terms));
+  return i;
+}
+
+bool
+CueTextIndex::addPosting(int term, int position)
+{
+  TextTerm &t = terms[term];
+  if(t.count == t.alloc) {
+    if(t.alloc > INT_MAX / 16)
+      return false;
+    int alloc = t.alloc ? t.alloc * 2 : 4;
+    TextPosting *p = static_cast<TextPosting *>(
+      ::realloc(t.postings, alloc * sizeof(TextPosting)));
+    if(!p)
+      return false;
+    t.postings = p;
+    t.alloc = alloc;
+  }
+  t.postings[t.count].cue = numCues;
+  t.postings[t.count].position = position;
+  ++t.count;
+  return true;
+}
+
+bool
+CueTextIndex::growCues()
+{
+  if(cueAlloc > INT_MAX / 32)
+    return false;
+  int alloc = cueAlloc ? cueAlloc * 2 : 64;
+  Milliseconds *s = static_cast<Milliseconds *>(
+    ::realloc(starts, alloc * sizeof(Milliseconds)));
+  if(!s)
+    return false;
+  starts = s;
+  Milliseconds *e = static_cast<Milliseconds *>(
+    ::realloc(ends, alloc * sizeof(Milliseconds)));
+  if(!e)
+    return false;
+  ends = e;
+  cueAlloc = alloc;
+  startColumn = starts;
+  endColumn = ends;
+  return true;
+}
+
+} // TimedText
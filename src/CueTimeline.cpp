@@ -0,0 +1,249 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/CueTimeline.h>
+#include <cstdlib>
+#include <cstring>
+
+namespace TimedText
+{
+
+// Nodes form an implicit tree over the array, as in Heng Li's cgranges: the
+// level of node 'i' is the number of trailing 1 bits in 'i', and its children
+// are 'i' -/+ 2^(level-1). Every node up to 2^(rootLevel+1)-1 is allocated,
+// so a node's children always exist; those past the last cue are unused.
+struct CueTimeline::Entry
+{
+  Milliseconds start;
+  Milliseconds end;
+  // Latest end time of this node and its descendants
+  Milliseconds maxEnd;
+};
+
+// Start time of unused nodes, which sorts after every cue
+static const Milliseconds UnusedStart = Milliseconds(~uint64(0) >> 1);
+
+static inline int
+nodeLevel(int i)
+{
+  int level = 0;
+  while(i & 1)
+    i >>= 1, ++level;
+  return level;
+}
+
+static inline Milliseconds
+maximum(Milliseconds a, Milliseconds b)
+{
+  return a > b ? a : b;
+}
+
+CueTimeline::CueTimeline()
+  : entries(0), numEntries(0), rootLevel(-1)
+{
+}
+
+CueTimeline::CueTimeline(const List<Cue> &list)
+  : entries(0), numEntries(0), rootLevel(-1)
+{
+  insert(list);
+}
+
+CueTimeline::~CueTimeline()
+{
+  ::free(entries);
+}
+
+bool
+CueTimeline::insert(const Cue &cue)
+{
+  bool reordered = false;
+  if(!insertCue(cue, reordered))
+    return false;
+  if(reordered)
+    rebuild();
+  return true;
+}
+
+bool
+CueTimeline::insert(const List<Cue> &list)
+{
+  bool result = true;
+  bool reordered = false;
+  Cue cue;
+  for(int i = 0; i < list.count(); ++i) {
+    if(list.itemAt(i, cue) && !insertCue(cue, reordered))
+      result = false;
+  }
+  // Cues inserted out of order are only indexed once, after all of them
+  if(reordered)
+    rebuild();
+  return result;
+}
+
+void
+CueTimeline::clear()
+{
+  ::free(entries);
+  entries = 0;
+  numEntries = 0;
+  rootLevel = -1;
+  cues.clear();
+}
+
+bool
+CueTimeline::activeCues(Timestamp time, List<Cue> &result) const
+{
+  if(time.isMalformed())
+    return false;
+  Milliseconds t = time;
+  return cuesBetween(t, t + 1, result);
+}
+
+bool
+CueTimeline::cuesBetween(Timestamp from, Timestamp to,
+                         List<Cue> &result) const
+{
+  if(from.isMalformed() || to.isMalformed())
+    return false;
+  if(!cues.count() || Milliseconds(to) <= Milliseconds(from))
+    return true;
+  return collect((1 << rootLevel) - 1, rootLevel, from, to, result);
+}
+
+bool
+CueTimeline::insertCue(const Cue &cue, bool &reordered)
+{
+  Timestamp start = cue.startTime();
+  Timestamp end = cue.endTime();
+  if(start.isMalformed() || end.isMalformed())
+    return false;
+
+  int n = cues.count();
+  if(n == numEntries && !grow())
+    return false;
+
+  int i = n;
+  if(n && Milliseconds(start) < entries[n - 1].start) {
+    // Insert after any cues with the same start time
+    int lo = 0, hi = n;
+    while(lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if(entries[mid].start <= Milliseconds(start))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    i = lo;
+    if(!cues.insert(i, cue))
+      return false;
+    ::memmove(entries + i + 1, entries + i, (n - i) * sizeof(Entry));
+    // The latest end times are recomputed by rebuild()
+    reordered = true;
+  } else if(!cues.push(cue)) {
+    return false;
+  }
+
+  entries[i].start = start;
+  entries[i].end = end;
+  if(reordered)
+    return true;
+
+  // Appended after every other cue: only the new node and its ancestors
+  // can end any later.
+  for(int level = nodeLevel(i);; ++level) {
+    entries[i].maxEnd = maximum(entries[i].maxEnd, end);
+    if(level == rootLevel)
+      break;
+    if((i >> (level + 1)) & 1)
+      i -= 1 << level;
+    else
+      i += 1 << level;
+  }
+  return true;
+}
+
+bool
+CueTimeline::grow()
+{
+  // The current tree becomes the left subtree of a new root
+  if(numEntries > (INT_MAX - 1) / 2)
+    return false;
+  int alloc = numEntries * 2 + 1;
+  Entry *x = static_cast<Entry *>(::realloc(entries, alloc * sizeof(Entry)));
+  if(!x)
+    return false;
+  for(int i = numEntries; i < alloc; ++i) {
+    x[i].start = UnusedStart;
+    x[i].end = MalformedTimestamp;
+    x[i].maxEnd = MalformedTimestamp;
+  }
+  if(numEntries)
+    x[numEntries].maxEnd = x[(1 << rootLevel) - 1].maxEnd;
+  entries = x;
+  numEntries = alloc;
+  ++rootLevel;
+  return true;
+}
+
+void
+CueTimeline::rebuild()
+{
+  for(int level = 0; level <= rootLevel; ++level) {
+    int half = level ? 1 << (level - 1) : 0;
+    for(int i = (1 << level) - 1; i < numEntries; i += 1 << (level + 1)) {
+      Milliseconds end = entries[i].end;
+      if(level)
+        end = maximum(end, maximum(entries[i - half].maxEnd,
+                                   entries[i + half].maxEnd));
+      entries[i].maxEnd = end;
+    }
+  }
+}
+
+bool
+CueTimeline::collect(int i, int level, Milliseconds from, Milliseconds to,
+                     List<Cue> &result) const
+{
+  const Entry &e = entries[i];
+  if(e.maxEnd <= from)
+    return true;
+  int half = level ? 1 << (level - 1) : 0;
+  if(level && !collect(i - half, level - 1, from, to, result))
+    return false;
+  // Nothing to the right starts any earlier
+  if(e.start >= to)
+    return true;
+  if(e.end > from) {
+    Cue cue;
+    if(!cues.itemAt(i, cue) || !result.push(cue))
+      return false;
+  }
+  return !level || collect(i + half, level - 1, from, to, result);
+}
+
+} // TimedText
@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/CuetextCache.h>
+#include "HashChains.h"
+#include <cstdlib>
+
+namespace TimedText
+{
+
+struct CuetextCache::Entry
+{
+  uint32 hash;
+  String text;
+  Node tree;
+  Entry *next;
+};
+
+CuetextCache::CuetextCache(int capacity)
+  : buckets(0), numBuckets(0), numEntries(0),
+    maxEntries(capacity > 0 ? capacity : 1), evictCursor(0)
+{
+}
+
+CuetextCache::~CuetextCache()
+{
+  clear();
+  ::free(buckets);
+}
+
+bool
+CuetextCache::find(const String &cuetext, Node &result) const
+{
+  if(!numEntries)
+    return false;
+  uint32 hash = cuetext.hash();
+  for(Entry *e = hashBucket(buckets, numBuckets, hash); e; e = e->next) {
+    if(e->hash == hash && e->text == cuetext) {
+      result = e->tree;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool
+CuetextCache::insert(const String &cuetext, const Node &tree)
+{
+  uint32 hash = cuetext.hash();
+  if(numEntries) {
+    for(Entry *e = hashBucket(buckets, numBuckets, hash); e; e = e->next) {
+      if(e->hash == hash && e->text == cuetext) {
+        e->tree = tree;
+        return true;
+      }
+    }
+  }
+
+  if(numEntries >= maxEntries) {
+    // Make room by dropping a single tree, rather than all of them
+    delete evictEntry(buckets, numBuckets, evictCursor);
+    --numEntries;
+  }
+  if(!reserveBuckets(buckets, numBuckets, numEntries, 8,
+                     HashEntryPointers<Entry>()))
+    return false;
+  Entry *e = new Entry;
+  if(!e)
+    return false;
+  e->hash = hash;
+  e->text = cuetext;
+  e->tree = tree;
+  linkEntry(buckets, numBuckets, e, HashEntryPointers<Entry>());
+  ++numEntries;
+  return true;
+}
+
+void
+CuetextCache::clear()
+{
+  for(int i=0; i<numBuckets; ++i) {
+    Entry *e = buckets[i];
+    while(e) {
+      Entry *next = e->next;
+      delete e;
+      e = next;
+    }
+    buckets[i] = 0;
+  }
+  numEntries = 0;
+}
+
+} // TimedText
@@ -0,0 +1,172 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __TimedText_HashChains__
+#define __TimedText_HashChains__
+
+#include <TimedText/Types.h>
+#include <climits>
+#include <cstdlib>
+
+namespace TimedText
+{
+
+// Helpers for the chained hash tables of the library's caches and indexes.
+//
+// A table is an array of buckets, whose size is a power of two. Each bucket
+// holds the link to the first entry of a chain, and each entry links to the
+// next through its own 'next' member. A link is either a pointer to an
+// entry, which is 0 at the end of a chain, or the index of an entry in an
+// array, which is -1 at the end. Entries also have a 'hash' member, which
+// chooses their bucket. 'entries' maps a link to the entry it refers to.
+
+template <typename Link>
+struct HashLink
+{
+  static inline Link end() {
+    return 0;
+  }
+};
+
+template <>
+struct HashLink<int>
+{
+  static inline int end() {
+    return -1;
+  }
+};
+
+// Map pointer links to their entries
+template <typename Entry>
+struct HashEntryPointers
+{
+  inline Entry &operator()(Entry *e) const {
+    return *e;
+  }
+};
+
+// Map index links to entries of an array
+template <typename Entry>
+struct HashEntryArray
+{
+  HashEntryArray(Entry *base) : base(base) {}
+  inline Entry &operator()(int i) const {
+    return base[i];
+  }
+  Entry *base;
+};
+
+template <typename Link>
+inline Link &
+hashBucket(Link *buckets, int numBuckets, uint64 hash)
+{
+  return buckets[uint32(hash) & uint32(numBuckets - 1)];
+}
+
+// Make room for another entry in a table holding 'count' of them, so that
+// there are more buckets than entries. The buckets are doubled as needed,
+// from 'minimum' if there are none yet, and the entries are moved to their
+// new buckets. Returns false, leaving the table as it was, if it cannot be
+// grown.
+template <typename Link, typename Entries>
+bool
+reserveBuckets(Link *&buckets, int &numBuckets, int count, int minimum,
+               const Entries &entries)
+{
+  if(count < numBuckets)
+    return true;
+  int n = numBuckets ? numBuckets : minimum;
+  while(n <= count) {
+    if(n > INT_MAX / 2)
+      return false;
+    n <<= 1;
+  }
+  Link *x = static_cast<Link *>(::malloc(size_t(n) * sizeof(Link)));
+  if(!x)
+    return false;
+  for(int i = 0; i < n; ++i)
+    x[i] = HashLink<Link>::end();
+  for(int i = 0; i < numBuckets; ++i) {
+    Link e = buckets[i];
+    while(e != HashLink<Link>::end()) {
+      Link next = entries(e).next;
+      Link &bucket = hashBucket(x, n, entries(e).hash);
+      entries(e).next = bucket;
+      bucket = e;
+      e = next;
+    }
+  }
+  ::free(buckets);
+  buckets = x;
+  numBuckets = n;
+  return true;
+}
+
+// Add entry 'e' to the front of its chain
+template <typename Link, typename Entries>
+inline void
+linkEntry(Link *buckets, int numBuckets, Link e, const Entries &entries)
+{
+  Link &bucket = hashBucket(buckets, numBuckets, entries(e).hash);
+  entries(e).next = bucket;
+  bucket = e;
+}
+
+// Remove entry 'e' from its chain
+template <typename Link, typename Entries>
+inline void
+unlinkEntry(Link *buckets, int numBuckets, Link e, const Entries &entries)
+{
+  Link *link = &hashBucket(buckets, numBuckets, entries(e).hash);
+  while(*link != e)
+    link = &entries(*link).next;
+  *link = entries(e).next;
+}
+
+// Unlink and return an entry to be evicted from a table which is not
+// empty: the oldest entry of the next bucket, from 'cursor' on, which holds
+// any. Buckets are visited in turn over successive calls, so every entry is
+// eventually evicted, and the recently added ones last within each chain.
+template <typename Entry>
+Entry *
+evictEntry(Entry **buckets, int numBuckets, int &cursor)
+{
+  Entry **link;
+  do {
+    link = &buckets[cursor];
+    cursor = (cursor + 1) & (numBuckets - 1);
+  } while(!*link);
+  while((*link)->next)
+    link = &(*link)->next;
+  Entry *e = *link;
+  *link = 0;
+  return e;
+}
+
+} // TimedText
+
+#endif // __TimedText_HashChains__
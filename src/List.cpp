@@ -70,23 +70,25 @@ ListData::Data *ListData::sharedNull()
 }
 
 ListData::Data *ListData::detach(int alloc) {
+  if(alloc < d->alloc)
+    alloc = d->alloc;
   Data *x = static_cast<Data *>(
-    ::malloc(DataHeaderSize + d->alloc * sizeof(void *)));
+    ::malloc(DataHeaderSize + alloc * sizeof(void *)));
   if(!x)
     return 0;
   x->ref = 1;
-  x->alloc = d->alloc;
+  x->alloc = alloc;
   if(!x->alloc)
     x->begin = x->end = 0;
   else {
     x->begin = d->begin;
     x->end = d->end;
   }
+  // As with detach_grow(), the caller copies the items and releases the old
+  // data
   Data *y = d;
   d = x;
-  if(!y->ref.deref())
-    return y;
-  return 0;
+  return y;
 }
 
 ListData::Data *
@@ -132,6 +134,24 @@ ListData::realloc(int alloc) {
   return true;
 }
 
+bool
+ListData::reserve(int alloc) {
+  if(d->ref != 1)
+    return false;
+  if(d->begin + alloc <= d->alloc)
+    return true;
+  if(d->begin) {
+    // Move items to the front, to make use of all of the space after them
+    int size = d->end - d->begin;
+    ::memmove(d->array, d->array + d->begin, size * sizeof(void *));
+    d->begin = 0;
+    d->end = size;
+  }
+  if(alloc <= d->alloc)
+    return true;
+  return realloc(alloc);
+}
+
 void **
 ListData::erase(void **xi) {
   if(d->ref != 1)
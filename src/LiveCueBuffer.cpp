@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/LiveCueBuffer.h>
+
+namespace TimedText
+{
+
+LiveCueBuffer::LiveCueBuffer(Milliseconds retention)
+  : edge(MalformedTimestamp), keep(retention < 0 ? 0 : retention),
+    numEvicted(0)
+{
+}
+
+bool
+LiveCueBuffer::append(const Cue &cue)
+{
+  Timestamp startTime = cue.startTime();
+  Timestamp endTime = cue.endTime();
+  if(startTime.isMalformed() || endTime.isMalformed())
+    return false;
+  Milliseconds start = startTime;
+  Milliseconds end = endTime;
+  if(start > edge)
+    edge = start;
+  if(end < edge - keep) {
+    ++numEvicted;
+    evict();
+    return true;
+  }
+
+  // Cues of a live stream mostly arrive in order of end time, and are
+  // appended. Others go after any cues ending at the same time.
+  int n = ends.count();
+  int i = n;
+  if(n && ends[n - 1] > end) {
+    int lo = 0;
+    int hi = n;
+    while(lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if(ends[mid] <= end)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    i = lo;
+  }
+  if(!ends.insert(i, end))
+    return false;
+  if(!cues.insert(i, cue)) {
+    Milliseconds dropped;
+    ends.take(i, dropped);
+    return false;
+  }
+  evict();
+  return true;
+}
+
+bool
+LiveCueBuffer::append(const List<Cue> &list)
+{
+  for(List<Cue>::const_iterator it = list.begin(); it != list.end(); ++it) {
+    if(!append(*it))
+      return false;
+  }
+  return true;
+}
+
+void
+LiveCueBuffer::setLiveEdge(Timestamp time)
+{
+  if(time.isMalformed())
+    return;
+  Milliseconds ms = time;
+  if(ms > edge) {
+    edge = ms;
+    evict();
+  }
+}
+
+void
+LiveCueBuffer::setRetention(Milliseconds retention)
+{
+  keep = retention < 0 ? 0 : retention;
+  evict();
+}
+
+void
+LiveCueBuffer::clear()
+{
+  cues.clear();
+  ends.clear();
+  edge = MalformedTimestamp;
+}
+
+// The expired cues are a prefix of the list, which is removed by moving
+// the start of the list rather than the cues after it.
+void
+LiveCueBuffer::evict()
+{
+  Milliseconds limit = edge - keep;
+  int n = ends.count();
+  int expired = 0;
+  while(expired < n && ends[expired] < limit)
+    ++expired;
+  if(!expired)
+    return;
+  ends.erase(ends.begin(), ends.begin() + expired);
+  cues.erase(cues.begin(), cues.begin() + expired);
+  numEvicted += expired;
+}
+
+} // TimedText
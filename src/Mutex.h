@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __TimedText_Mutex__
+#define __TimedText_Mutex__
+
+#if defined(_WIN32)
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#  define USE_WIN32_MUTEX
+#else
+#  include <pthread.h>
+#  define USE_PTHREAD_MUTEX
+#endif
+
+namespace TimedText
+{
+
+// Minimal mutex and condition variable, for the few objects which are
+// shared between threads.
+class Mutex
+{
+public:
+#if defined(USE_WIN32_MUTEX)
+  Mutex() { InitializeSRWLock(&m); }
+  ~Mutex() {}
+  void lock() { AcquireSRWLockExclusive(&m); }
+  void unlock() { ReleaseSRWLockExclusive(&m); }
+#else
+  Mutex() { pthread_mutex_init(&m, 0); }
+  ~Mutex() { pthread_mutex_destroy(&m); }
+  void lock() { pthread_mutex_lock(&m); }
+  void unlock() { pthread_mutex_unlock(&m); }
+#endif
+
+private:
+  friend class Condition;
+#if defined(USE_WIN32_MUTEX)
+  SRWLOCK m;
+#else
+  pthread_mutex_t m;
+#endif
+
+  // Not copyable
+  Mutex(const Mutex &);
+  Mutex &operator=(const Mutex &);
+};
+
+class Condition
+{
+public:
+#if defined(USE_WIN32_MUTEX)
+  Condition() { InitializeConditionVariable(&c); }
+  ~Condition() {}
+  // Wait until woken, with 'mutex' locked by the caller
+  void wait(Mutex &mutex) {
+    SleepConditionVariableSRW(&c, &mutex.m, INFINITE, 0);
+  }
+  void broadcast() { WakeAllConditionVariable(&c); }
+#else
+  Condition() { pthread_cond_init(&c, 0); }
+  ~Condition() { pthread_cond_destroy(&c); }
+  // Wait until woken, with 'mutex' locked by the caller
+  void wait(Mutex &mutex) { pthread_cond_wait(&c, &mutex.m); }
+  void broadcast() { pthread_cond_broadcast(&c); }
+#endif
+
+private:
+#if defined(USE_WIN32_MUTEX)
+  CONDITION_VARIABLE c;
+#else
+  pthread_cond_t c;
+#endif
+
+  // Not copyable
+  Condition(const Condition &);
+  Condition &operator=(const Condition &);
+};
+
+// Holds a mutex locked for the duration of a scope
+class MutexLocker
+{
+public:
+  MutexLocker(Mutex &m) : mutex(m) { mutex.lock(); }
+  ~MutexLocker() { mutex.unlock(); }
+private:
+  Mutex &mutex;
+};
+
+} // TimedText
+
+#endif // __TimedText_Mutex__
@@ -36,6 +36,16 @@ public:
   EmptyNodeData() : NodeData(EmptyNode,NullNode) {}
 } emptyNode;
 
+// Every handle to the shared empty node holds a reference to it, moved-from
+// handles included, so that it is never released, nor taken by detach() to
+// be unshared.
+NodeData *
+Node::sharedEmpty()
+{
+  emptyNode.ref.ref();
+  return &emptyNode;
+}
+
 Node::Node()
   : d(&emptyNode)
 {
@@ -178,31 +188,31 @@ Node::applicableClasses() const
 bool
 Node::setTimestamp(const Timestamp &ts)
 {
-  return d->setTimestamp(ts);
+  return detach() && d->setTimestamp(ts);
 }
 
 bool
 Node::setVoice(const String &voice)
 {
-  return d->setVoice(voice);
+  return detach() && d->setVoice(voice);
 }
 
 bool
 Node::setText(const String &text)
 {
-  return d->setText(text);
+  return detach() && d->setText(text);
 }
 
 bool
 Node::setLang(const String &lang)
 {
-  return d->setLang(lang);
+  return detach() && d->setLang(lang);
 }
 
 bool
 Node::setApplicableClasses(const List<String> &classes)
 {
-  return d->setApplicableClasses(classes);
+  return detach() && d->setApplicableClasses(classes);
 }
 
 const List<Node> &
@@ -214,37 +224,43 @@ Node::children() const
 bool
 Node::push(const Node &node)
 {
-  return d->push(node);
+  return detach() && d->push(node);
+}
+
+bool
+Node::pushMoved(Node &node)
+{
+  return detach() && d->pushMoved(node);
 }
 
 bool
 Node::pop(Node &result)
 {
-  return d->pop(result);
+  return detach() && d->pop(result);
 }
 
 bool
 Node::unshift(const Node &node)
 {
-  return d->unshift(node);
+  return detach() && d->unshift(node);
 }
 
 bool
 Node::shift(Node &result)
 {
-  return d->shift(result);
+  return detach() && d->shift(result);
 }
 
 bool
 Node::insert(int i, const Node &node)
 {
-  return d->insert(i, node);
+  return detach() && d->insert(i, node);
 }
 
 bool
 Node::take(int i, Node &result)
 {
-  return d->take(i, result);
+  return detach() && d->take(i, result);
 }
 
 bool
@@ -256,12 +272,14 @@ Node::itemAt(int i, Node &result)
 Node::iterator
 Node::begin()
 {
+  detach();
   return d->begin();
 }
 
 Node::iterator
 Node::end()
 {
+  detach();
   return d->end();
 }
 
@@ -285,63 +303,27 @@ Node::childCount() const
   return d->childCount();
 }
 
-struct VisitState
+bool
+Node::detach()
 {
-public:
-  inline VisitState() : i(0) {}
-  inline VisitState(const VisitState &v) : n(v.n), i(v.i) {}
-  inline VisitState(const Node &node) : n(node), i(0) {}
-  inline VisitState(const Node &node, int pos) : n(node), i(pos) {}
-  inline bool hasChildren() const { return n.childCount() > 0; }
-  inline bool isLeaf() const { return n.type() == LeafNode; }
-  inline bool isInternal() const { return n.type() == InternalNode; }
-  inline bool isInternalText() const {
-    return n.element() == InternalTextNode;
-  }
-  inline bool isEmpty() const { return n.type() == EmptyNode; }
-  inline bool next(VisitState &result) {
-    Node tmp;
-    if(n.itemAt(i++, tmp)) {
-      result = VisitState(tmp);
-      return true;
-    }
+  if(d->ref == 1)
+    return true;
+  // Leaf and internal nodes are cloned, the shared empty node can't be, but
+  // none of the routines which detach are valid for it anyway.
+  NodeData *x = d->clone();
+  if(!x)
     return false;
-  }
-  operator Node &() { return n; }
-  operator const Node &() const { return n; }
-
-  Node n;
-  int i;
-};
+  x->ref = 1;
+  if(!d->ref.deref())
+    delete d;
+  d = x;
+  return true;
+}
 
 void
-Node::visit(NodeVisitor &visitor)
-{
-  List<VisitState> stack;
-  stack.push(*this);
-  VisitState *top;
-  while(stack.lastPtr(top)) {
-    VisitState it;
-    if(top->next(it)) {
-      // Don't visit empty nodes.
-      if(it.isEmpty())
-        continue;
-      // Visit the item before descending
-      visitor.visit(it);
-
-      // We might need to descend, if it's
-      if(it.isInternal()) {
-        if(it.hasChildren() && (it.isInternalText() || visitor.enter(it)))
-          stack.push(it);
-      }
-    } else {
-      // Notify visitor that we are leaving a branch of the tree
-      if(!top->isInternalText())
-        visitor.leave(*top);
-      stack.pop(it);
-    }
-  }
+Node::visit(NodeVisitor &visitor) const
+{
+  traverse(*this, visitor);
 }
 
-
 } // TimedText
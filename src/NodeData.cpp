@@ -26,6 +26,7 @@
 //
 
 #include "NodeData.h"
+#include "Utility.h"
 
 namespace TimedText
 {
@@ -42,6 +43,12 @@ NodeData::~NodeData()
 {
 }
 
+NodeData *
+NodeData::clone() const
+{
+  return 0;
+}
+
 Timestamp
 NodeData::timestamp() const
 {
@@ -115,6 +122,12 @@ NodeData::push(const Node &node)
   return false;
 }
 
+bool
+NodeData::pushMoved(Node &node)
+{
+  return false;
+}
+
 bool
 NodeData::pop(Node &result)
 {
@@ -192,6 +205,12 @@ InternalNodeData::~InternalNodeData()
 {
 }
 
+NodeData *
+InternalNodeData::clone() const
+{
+  return new InternalNodeData(*this);
+}
+
 const List<Node> &
 InternalNodeData::children() const
 {
@@ -204,6 +223,20 @@ InternalNodeData::push(const Node &node)
   return nodes.push(node);
 }
 
+bool
+InternalNodeData::pushMoved(Node &node)
+{
+#if defined(TT_HAVE_RVALUE_REFS)
+  return nodes.push(move(node));
+#else
+  // Callers built with rvalue references expect 'node' to be left empty
+  if(!nodes.push(Node()))
+    return false;
+  nodes[nodes.count() - 1].swap(node);
+  return true;
+#endif
+}
+
 bool
 InternalNodeData::pop(Node &result)
 {
@@ -273,6 +306,12 @@ ElementNodeData::~ElementNodeData()
 {
 }
 
+NodeData *
+ElementNodeData::clone() const
+{
+  return new ElementNodeData(*this);
+}
+
 int
 InternalNodeData::childCount() const
 {
@@ -303,6 +342,12 @@ VoiceNodeData::~VoiceNodeData()
 {
 }
 
+NodeData *
+VoiceNodeData::clone() const
+{
+  return new VoiceNodeData(*this);
+}
+
 String
 VoiceNodeData::voice() const
 {
@@ -325,6 +370,12 @@ LangNodeData::~LangNodeData()
 {
 }
 
+NodeData *
+LangNodeData::clone() const
+{
+  return new LangNodeData(*this);
+}
+
 String
 LangNodeData::lang() const
 {
@@ -348,6 +399,12 @@ TextNodeData::~TextNodeData()
 {
 }
 
+NodeData *
+TextNodeData::clone() const
+{
+  return new TextNodeData(*this);
+}
+
 String
 TextNodeData::text() const
 {
@@ -370,6 +427,12 @@ TimestampNodeData::~TimestampNodeData()
 {
 }
 
+NodeData *
+TimestampNodeData::clone() const
+{
+  return new TimestampNodeData(*this);
+}
+
 Timestamp
 TimestampNodeData::timestamp() const
 {
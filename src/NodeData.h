@@ -43,6 +43,8 @@ public:
   typedef Node::const_iterator const_iterator;
   NodeData(NodeType _type, NodeElementType _elem);
   virtual ~NodeData();
+  // Return a new copy of this node, sharing its children.
+  virtual NodeData *clone() const;
   virtual Timestamp timestamp() const;
   virtual String voice() const;
   virtual String text() const;
@@ -55,6 +57,7 @@ public:
   virtual bool setApplicableClasses(const List<String> &applicableClasses);
   virtual const List<Node> &children() const;
   virtual bool push(const Node &node);
+  virtual bool pushMoved(Node &node);
   virtual bool pop(Node &result);
   virtual bool unshift(const Node &node);
   virtual bool shift(Node &result);
@@ -78,9 +81,11 @@ class InternalNodeData : public NodeData
 public:
   InternalNodeData(NodeElementType elem);
   virtual ~InternalNodeData();
+  NodeData *clone() const;
 
   const List<Node> &children() const;
   bool push(const Node &node);
+  bool pushMoved(Node &node);
   bool pop(Node &result);
   bool unshift(const Node &node);
   bool shift(Node &result);
@@ -101,6 +106,7 @@ class ElementNodeData : public InternalNodeData
 public:
   ElementNodeData(NodeElementType type);
   virtual ~ElementNodeData();
+  NodeData *clone() const;
   List<String> applicableClasses() const;
   bool setApplicableClasses(const List<String> &style);
   List<String> _applicableClasses;
@@ -111,6 +117,7 @@ class VoiceNodeData : public ElementNodeData
 public:
   VoiceNodeData();
   ~VoiceNodeData();
+  NodeData *clone() const;
 
   String voice() const;
   bool setVoice(const String &voice);
@@ -123,6 +130,7 @@ class LangNodeData : public ElementNodeData
 public:
   LangNodeData();
   ~LangNodeData();
+  NodeData *clone() const;
 
   String lang() const;
   bool setLang(const String &lang);
@@ -136,6 +144,7 @@ class TextNodeData : public NodeData
 public:
   TextNodeData();
   ~TextNodeData();
+  NodeData *clone() const;
 
   String text() const;
   bool setText(const String &text);
@@ -148,6 +157,7 @@ class TimestampNodeData : public NodeData
 public:
   TimestampNodeData();
   ~TimestampNodeData();
+  NodeData *clone() const;
 
   Timestamp timestamp() const;
   bool setTimestamp(const Timestamp &ts);
@@ -0,0 +1,82 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __TimedText_PackedCueSettings__
+#define __TimedText_PackedCueSettings__
+
+#include <TimedText/Cue.h>
+
+namespace TimedText
+{
+
+// The settings of a cue packed into 8 bytes, as stored by CueStore and in
+// track images. The layout is part of the track image format.
+struct PackedCueSettings
+{
+  enum
+  {
+    SnapToLinesFlag = 0x01,
+    VerticalShift = 1,
+    VerticalMask = 0x06,
+    AlignShift = 3,
+    AlignMask = 0x38,
+    NullIdFlag = 0x40,
+    NullTextFlag = 0x80
+  };
+
+  int32 line;
+  uint8 size;
+  uint8 position;
+  uint8 flags;
+  uint8 type;
+
+  // The null flags are left for the caller, which already has the strings
+  inline void pack(const Cue &cue) {
+    type = uint8(cue.type());
+    line = cue.line();
+    size = uint8(cue.size());
+    position = uint8(cue.position());
+    flags = uint8(((cue.vertical() << VerticalShift) & VerticalMask)
+                  | ((cue.align() << AlignShift) & AlignMask));
+    if(cue.snapToLines())
+      flags |= SnapToLinesFlag;
+  }
+
+  inline void apply(Cue &cue) const {
+    if(type != WebVTTCue)
+      return;
+    cue.setLine(line, !!(flags & SnapToLinesFlag));
+    cue.setSize(size);
+    cue.setPosition(position);
+    cue.setVertical(Cue::Vertical((flags & VerticalMask) >> VerticalShift));
+    cue.setAlign(Cue::Align((flags & AlignMask) >> AlignShift));
+  }
+};
+
+} // TimedText
+
+#endif // __TimedText_PackedCueSettings__
@@ -0,0 +1,343 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/ParseCache.h>
+#include <TimedText/CuetextCache.h>
+#include <TimedText/SynchronousBuffer.h>
+#include <TimedText/WebVTTParser.h>
+#include "WebVTTCueData.h"
+#include "PackedCueSettings.h"
+#include "HashChains.h"
+#include "Mutex.h"
+#include "Utility.h"
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+namespace TimedText
+{
+
+struct ParseCache::Entry
+{
+  uint64 hash;
+  // Copy of the document, compared on every hit so that documents which
+  // merely share a hash are never confused
+  char *text;
+  int length;
+  int flags;
+  List<Cue> cues;
+  int cost;
+  // False while the document is being parsed
+  bool finished;
+  bool ok;
+  // Set if parsing ran out of memory. Threads already waiting still take
+  // the result, but the entry is not found again, and is dropped once they
+  // are done with it.
+  bool stale;
+  // Threads waiting for, or reading, this entry. It is not removed until
+  // they are done with it.
+  int waiters;
+  Entry *next;
+  Entry *newer;
+  Entry *older;
+};
+
+struct ParseCache::Shared
+{
+  Mutex mutex;
+  // Signalled when any document has been parsed
+  Condition finished;
+};
+
+// 'status' is Aborted if the document is not WebVTT, which is worth
+// remembering. As the whole document is given at once, it is only left
+// Unfinished if memory ran out.
+static bool
+parseDocument(const char *data, int len, int flags, List<Cue> &result,
+              WebVTTParser::Status &status)
+{
+  SynchronousBuffer buffer;
+  WebVTTParser parser(buffer);
+  status = WebVTTParser::Unfinished;
+  if(!buffer.refill(data, len, true))
+    return false;
+  bool ok = parser.parse(&status);
+  parser.parsedCues(result);
+  if(ok && (flags & ParseCache::ParseCuetext)) {
+    CuetextCache trees;
+    for(List<Cue>::iterator i = result.begin(); i != result.end(); ++i)
+      WebVTTParser::parseCuetext(*i, trees);
+  }
+  return ok;
+}
+
+// Callers may modify the cues they are given, for instance by parsing their
+// text, so each is given cues of its own. These share the ids, text and
+// trees of the cached cues, which are never modified in place.
+static bool
+copyCues(const List<Cue> &cues, List<Cue> &result)
+{
+  List<Cue> copies;
+  if(!copies.reserve(cues.count()))
+    return false;
+  for(List<Cue>::const_iterator i = cues.begin(); i != cues.end(); ++i) {
+    Cue cue(i->type(), i->startTime(), i->endTime(), i->id(), i->text());
+    PackedCueSettings settings;
+    settings.pack(*i);
+    settings.apply(cue);
+    Node tree;
+    if(i->nodes(tree))
+      cue.setNodes(tree);
+    if(!copies.push(cue))
+      return false;
+  }
+  result = copies;
+  return true;
+}
+
+ParseCache::ParseCache(int budget)
+  : shared(new Shared), buckets(0), numBuckets(0), numEntries(0),
+    totalCost(0), maxCost(budget > 0 ? budget : 0), numHits(0),
+    numMisses(0), newest(0), oldest(0)
+{
+}
+
+ParseCache::~ParseCache()
+{
+  for(int i = 0; i < numBuckets; ++i) {
+    while(buckets[i])
+      remove(buckets[i]);
+  }
+  ::free(buckets);
+  delete shared;
+}
+
+bool
+ParseCache::parse(const char *data, int len, List<Cue> &result, int flags)
+{
+  if(!data)
+    return false;
+  if(len < 0)
+    len = int(::strlen(data));
+  uint64 hash = hashBytes64(data, len, uint64(flags));
+
+  Entry *e;
+  List<Cue> cues;
+  bool ok = false;
+  bool hit = false;
+  {
+    MutexLocker locker(shared->mutex);
+    if((e = find(hash, data, len, flags))) {
+      ++numHits;
+      ++e->waiters;
+      while(!e->finished)
+        shared->finished.wait(shared->mutex);
+      --e->waiters;
+      cues = e->cues;
+      ok = e->ok;
+      hit = true;
+      if(e != newest) {
+        // Move to the front of the least recently used list
+        e->newer->older = e->older;
+        if(e->older)
+          e->older->newer = e->newer;
+        else
+          oldest = e->newer;
+        e->older = newest;
+        e->newer = 0;
+        newest->newer = e;
+        newest = e;
+      }
+      // Entries may have been kept past the budget while being waited for
+      if(!e->waiters) {
+        if(e->stale)
+          remove(e);
+        evict();
+      }
+    } else {
+      ++numMisses;
+      // If this fails, the document is still parsed, but not cached
+      e = new Entry;
+      char *text = static_cast<char *>(::malloc(size_t(len) + 1));
+      if(!e || !text) {
+        delete e;
+        ::free(text);
+        e = 0;
+      } else {
+        ::memcpy(text, data, len);
+        e->hash = hash;
+        e->text = text;
+        e->length = len;
+        e->flags = flags;
+        e->cost = 0;
+        e->finished = false;
+        e->ok = false;
+        e->stale = false;
+        e->waiters = 0;
+        e->newer = e->older = 0;
+        if(!insert(e)) {
+          ::free(e->text);
+          delete e;
+          e = 0;
+        }
+      }
+    }
+  }
+  if(hit)
+    return copyCues(cues, result) && ok;
+
+  // Other threads asking for the same document wait for this parse
+  WebVTTParser::Status status;
+  ok = parseDocument(data, len, flags, cues, status);
+  if(!e) {
+    result = cues;
+    return ok;
+  }
+  {
+    MutexLocker locker(shared->mutex);
+    int64 cost = int64(len) + int64(cues.count())
+               * int64(sizeof(WebVTTCueData) + sizeof(void *));
+    e->cues = cues;
+    e->ok = ok;
+    e->stale = status == WebVTTParser::Unfinished;
+    e->finished = true;
+    e->cost = cost > INT_MAX - totalCost ? INT_MAX - totalCost : int(cost);
+    totalCost += e->cost;
+    e->older = newest;
+    if(newest)
+      newest->newer = e;
+    else
+      oldest = e;
+    newest = e;
+    if(e->stale && !e->waiters)
+      remove(e);
+    evict();
+    shared->finished.broadcast();
+  }
+  return copyCues(cues, result) && ok;
+}
+
+void
+ParseCache::clear()
+{
+  MutexLocker locker(shared->mutex);
+  for(int i = 0; i < numBuckets; ++i) {
+    Entry *e = buckets[i];
+    while(e) {
+      Entry *next = e->next;
+      if(e->finished && !e->waiters)
+        remove(e);
+      e = next;
+    }
+  }
+}
+
+int
+ParseCache::count() const
+{
+  MutexLocker locker(shared->mutex);
+  return numEntries;
+}
+
+int
+ParseCache::cost() const
+{
+  MutexLocker locker(shared->mutex);
+  return totalCost;
+}
+
+int
+ParseCache::hits() const
+{
+  MutexLocker locker(shared->mutex);
+  return numHits;
+}
+
+int
+ParseCache::misses() const
+{
+  MutexLocker locker(shared->mutex);
+  return numMisses;
+}
+
+ParseCache::Entry *
+ParseCache::find(uint64 hash, const char *data, int len, int flags) const
+{
+  if(!numEntries)
+    return 0;
+  for(Entry *e = hashBucket(buckets, numBuckets, hash); e; e = e->next) {
+    if(e->hash == hash && e->length == len && e->flags == flags
+       && !e->stale && !::memcmp(e->text, data, len))
+      return e;
+  }
+  return 0;
+}
+
+bool
+ParseCache::insert(Entry *e)
+{
+  if(!reserveBuckets(buckets, numBuckets, numEntries, 16,
+                     HashEntryPointers<Entry>()))
+    return false;
+  linkEntry(buckets, numBuckets, e, HashEntryPointers<Entry>());
+  ++numEntries;
+  return true;
+}
+
+void
+ParseCache::remove(Entry *e)
+{
+  unlinkEntry(buckets, numBuckets, e, HashEntryPointers<Entry>());
+  if(e->finished) {
+    if(e->newer)
+      e->newer->older = e->older;
+    else
+      newest = e->older;
+    if(e->older)
+      e->older->newer = e->newer;
+    else
+      oldest = e->newer;
+  }
+  totalCost -= e->cost;
+  --numEntries;
+  ::free(e->text);
+  delete e;
+}
+
+void
+ParseCache::evict()
+{
+  Entry *e = oldest;
+  while(e && totalCost > maxCost) {
+    Entry *newer = e->newer;
+    if(!e->waiters)
+      remove(e);
+    e = newer;
+  }
+}
+
+} // TimedText
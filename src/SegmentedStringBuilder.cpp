@@ -0,0 +1,233 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#include <TimedText/SegmentedStringBuilder.h>
+#include <TimedText/StringBuilder.h>
+#include <cstdlib>
+
+namespace TimedText
+{
+
+struct SegmentedStringBuilder::Chunk
+{
+  Chunk *next;
+  // Text owned by the chunk, or NULL if it shares the buffer of 'shared'
+  char *buffer;
+  String shared;
+  int length;
+  int alloc;
+
+  inline const char *text() const {
+    return buffer ? buffer : shared.text();
+  }
+};
+
+SegmentedStringBuilder::SegmentedStringBuilder(int segmentSize)
+  : first(0), last(0), numChunks(0), totalLength(0),
+    chunkSize(segmentSize > 0 ? segmentSize : 4096)
+{
+}
+
+SegmentedStringBuilder::~SegmentedStringBuilder()
+{
+  clear();
+}
+
+int
+SegmentedStringBuilder::segments(Segment *out, int max, int from) const
+{
+  int n = 0;
+  int i = 0;
+  for(Chunk *c = first; c && n < max; c = c->next, ++i) {
+    if(i < from)
+      continue;
+    out[n].text = c->text();
+    out[n].length = c->length;
+    ++n;
+  }
+  return n;
+}
+
+// Return space for at least 'size' bytes at the end of the last segment,
+// starting a new segment if need be.
+char *
+SegmentedStringBuilder::reserve(int size)
+{
+  if(last && last->buffer && last->alloc - last->length >= size)
+    return last->buffer + last->length;
+  int alloc = size > chunkSize ? size : chunkSize;
+  Chunk *c = new Chunk;
+  if(!c)
+    return 0;
+  c->buffer = static_cast<char *>(::malloc(alloc));
+  if(!c->buffer) {
+    delete c;
+    return 0;
+  }
+  c->next = 0;
+  c->length = 0;
+  c->alloc = alloc;
+  if(last)
+    last->next = c;
+  else
+    first = c;
+  last = c;
+  ++numChunks;
+  return c->buffer;
+}
+
+bool
+SegmentedStringBuilder::append(const char *utf8, int len)
+{
+  if(!utf8)
+    return true;
+  if(len < 0)
+    len = ::strlen(utf8);
+  if(len == 0)
+    return true;
+  // Text is nearly always valid, in which case it is copied as is.
+  char *out = reserve(len);
+  if(!out)
+    return false;
+  int valid = Unicode::copyValidUtf8(out, utf8, len);
+  last->length += valid;
+  totalLength += valid;
+  if(valid < len) {
+    // Otherwise, replacing the invalid sequences may lengthen it, so the
+    // rest may need to start a new segment.
+    utf8 += valid;
+    len -= valid;
+    int vlen = Unicode::utf8Length(utf8, len);
+    if(!(out = reserve(vlen + 1)))
+      return false;
+    Unicode::toValidUtf8(out, vlen + 1, vlen, utf8, len);
+    last->length += vlen;
+    totalLength += vlen;
+  }
+  return true;
+}
+
+bool
+SegmentedStringBuilder::append(uint32 ucs4)
+{
+  char is[8];
+  int il;
+  Unicode::toUtf8(ucs4, is, il);
+  char *out = reserve(il);
+  if(!out)
+    return false;
+  ::memcpy(out, is, il);
+  last->length += il;
+  totalLength += il;
+  return true;
+}
+
+bool
+SegmentedStringBuilder::append(const String &str)
+{
+  int len = str.length();
+  if(len == 0)
+    return true;
+  if(len < chunkSize / 2) {
+    // Strings are always valid UTF8, and need not be checked
+    char *out = reserve(len);
+    if(!out)
+      return false;
+    ::memcpy(out, str.text(), len);
+    last->length += len;
+    totalLength += len;
+    return true;
+  }
+  Chunk *c = new Chunk;
+  if(!c)
+    return false;
+  c->next = 0;
+  c->buffer = 0;
+  c->shared = str;
+  c->length = len;
+  c->alloc = 0;
+  if(last)
+    last->next = c;
+  else
+    first = c;
+  last = c;
+  ++numChunks;
+  totalLength += len;
+  return true;
+}
+
+bool
+SegmentedStringBuilder::append(const StringBuilder &buf)
+{
+  // StringBuilders always hold valid UTF8 too
+  int len = buf.length();
+  if(len == 0)
+    return true;
+  char *out = reserve(len);
+  if(!out)
+    return false;
+  ::memcpy(out, buf.text(), len);
+  last->length += len;
+  totalLength += len;
+  return true;
+}
+
+bool
+SegmentedStringBuilder::toString(String &result) const
+{
+  if(first && first == last && !first->buffer) {
+    result = first->shared;
+    return true;
+  }
+  // The segments hold valid UTF8, so they are copied without checking
+  String str;
+  char *out = str.allocate(totalLength);
+  if(!out)
+    return false;
+  for(Chunk *c = first; c; c = c->next) {
+    ::memcpy(out, c->text(), c->length);
+    out += c->length;
+  }
+  result = str;
+  return true;
+}
+
+void
+SegmentedStringBuilder::clear()
+{
+  Chunk *c = first;
+  while(c) {
+    Chunk *next = c->next;
+    ::free(c->buffer);
+    delete c;
+    c = next;
+  }
+  first = last = 0;
+  numChunks = 0;
+  totalLength = 0;
+}
+
+} // TimedText
@@ -26,6 +26,7 @@
 //
 
 #include "StringData.h"
+#include "Utility.h"
 #include <cstring>
 #include <climits>
 #include <cstdlib>
@@ -33,105 +34,158 @@
 namespace TimedText
 {
 
-String::Data String::sharedEmpty = { AtomicInt(1), 0, { '\0' } };
-String::Data String::sharedNull = { AtomicInt(1), 0, { '\0' } };
+String::String() : tag(NullTag) { small[0] = '\0'; }
 
-String::String() : d(&sharedNull) { d->ref.ref(); }
-
-String::String(Data &dd) : d(&dd) { d->ref.ref(); }
+String::String(Data &dd) : d(&dd), tag(HeapTag) { d->ref.ref(); }
 
 String::String(const char *utf8, int len)
+  : tag(NullTag)
 {
+  small[0] = '\0';
   if(!utf8)
-    d = &sharedNull; 
-  else {
-    if(len < 0)
-      len = ::strlen(utf8);
-    if(len == 0)
-      d = &sharedEmpty;
-    else {
-      int alloc = Unicode::utf8Length(utf8,len);
-      d = static_cast<Data *>(::malloc(sizeof(Data) + alloc));
-      if(!d)
-        d = &sharedNull;
-      else {
-        d->ref = 0;
-        d->length = 0;
-        Unicode::toValidUtf8(d->text, alloc + 1, d->length, utf8, len);
-        d->text[d->length] = '\0';
-      }
-    }
+    return;
+  if(len < 0)
+    len = ::strlen(utf8);
+  // Text is nearly always valid, in which case it is copied as is.
+  char *out = allocate(len);
+  if(!out)
+    return;
+  int valid = Unicode::copyValidUtf8(out, utf8, len);
+  if(valid == len)
+    return;
+
+  // Otherwise, replacing the invalid sequences may lengthen it.
+  int alloc = valid + Unicode::utf8Length(utf8 + valid, len - valid);
+  String fixed;
+  char *x = fixed.allocate(alloc);
+  if(!x) {
+    release();
+    tag = NullTag;
+    small[0] = '\0';
+    return;
   }
-  d->ref.ref();
+  ::memcpy(x, out, valid);
+  int olen = 0;
+  Unicode::toValidUtf8(x + valid, alloc - valid + 1, olen,
+                       utf8 + valid, len - valid);
+  fixed.setLength(valid + olen);
+  operator=(fixed);
+}
+
+String
+String::fromValidUtf8(const char *utf8, int len)
+{
+  String result;
+  char *out = result.allocate(len);
+  if(out && len)
+    ::memcpy(out, utf8, len);
+  return result;
 }
 
 String::String(const String &str)
-  : d(str.d)
+  : tag(str.tag)
 {
-  d->ref.ref();
+  ::memcpy(small, str.small, sizeof(small));
+  if(!isSmall())
+    d->ref.ref();
 }
 
+// Sets up storage for 'size' bytes and a terminating NUL, replacing whatever
+// the string held without releasing it. Returns NULL, leaving a null string,
+// if memory could not be allocated.
+char *
+String::allocate(int size)
+{
+  if(size <= SmallCapacity) {
+    tag = static_cast<unsigned char>(size);
+    small[size] = '\0';
+    return small;
+  }
+  Data *x = static_cast<Data *>(::malloc(sizeof(Data) + size));
+  if(!x) {
+    tag = NullTag;
+    small[0] = '\0';
+    return 0;
+  }
+  x->ref = 1;
+  x->length = size;
+  x->hash = 0;
+  x->text[size] = '\0';
+  d = x;
+  tag = HeapTag;
+  return x->text;
+}
+
+// Shorten the string to 'size' bytes, which must be no more than it was
+// allocated with.
 void
-String::freeData(Data *x)
+String::setLength(int size)
 {
-  if(x->ref == 0)
-    // This should ideally be optimized out, but compiler is stupid...
-    if(x != &sharedNull)
-      ::free(x);
+  if(isSmall())
+    tag = static_cast<unsigned char>(size);
+  else
+    d->length = size;
+  const_cast<char *>(text())[size] = '\0';
 }
 
-bool
-String::realloc(int size)
+void
+String::release()
 {
-  if(d->ref != 1) {
-    Data *x = static_cast<Data *>(::malloc(sizeof(Data) + size));
-    if(!x)
-      return false;
-    x->length = size < d->length ? size : d->length;
-    ::memcpy(x->text, d->text, x->length);
-    x->text[x->length] = '\0';
-    x->ref = 1;
-    if(!d->ref.deref())
-      freeData(d);
-    d = x;
-  } else {
-    Data *x = static_cast<Data *>(::realloc(d, sizeof(Data) + size));
-    if(!x)
-      return false;
-    d = x;
-  }
-  return true;
+  if(!isSmall() && !d->ref.deref())
+    freeData(d);
+}
+
+void
+String::freeData(Data *x)
+{
+  ::free(x);
 }
 
 String::~String()
 {
-  if(!d->ref.deref())
-    freeData(d);
+  release();
 }
 
 String &
 String::operator=(const String &other)
 {
-  other.d->ref.ref();
-  if(!d->ref.deref())
-    freeData(d);
-  d = other.d;
+  if(!other.isSmall())
+    other.d->ref.ref();
+  release();
+  ::memcpy(small, other.small, sizeof(small));
+  tag = other.tag;
   return *this;
 }
 
 String &
 String::operator+=(const String &other)
 {
-  if(other.d != &sharedNull) {
-    if(d == &sharedNull)
-      operator=(other);
-    else {
-      if(!realloc(d->length + other.d->length))
-        return *this;
-      ::memcpy(d->text + d->length, other.d->text, other.d->length);
-      d->length += other.d->length;
-      d->text[d->length] = '\0';
-    }
+  if(other.isNull())
+    return *this;
+  if(isNull())
+    return operator=(other);
+  int len = length();
+  int otherLen = other.length();
+  if(otherLen == 0)
+    return *this;
+  if(!isSmall() && d->ref == 1) {
+    // We hold the only reference, so the buffer can grow in place
+    Data *x = static_cast<Data *>(::realloc(d, sizeof(Data) + len + otherLen));
+    if(!x)
+      return *this;
+    d = x;
+    ::memcpy(d->text + len, other.text(), otherLen);
+    d->length = len + otherLen;
+    d->hash = 0;
+    d->text[d->length] = '\0';
+    return *this;
+  }
+  String result;
+  char *out = result.allocate(len + otherLen);
+  if(out) {
+    ::memcpy(out, text(), len);
+    ::memcpy(out + len, other.text(), otherLen);
+    operator=(result);
   }
   return *this;
 }
@@ -139,18 +193,52 @@ String::operator+=(const String &other)
 int
 String::length() const
 {
+  if(isSmall())
+    return tag == NullTag ? 0 : tag;
   return d->length;
 }
 
 bool
 String::isNull() const {
-  return d == &sharedEmpty;
+  return tag == NullTag;
 }
 
 const char *
 String::text() const
 {
-  return d->text;
+  return isSmall() ? small : d->text;
+}
+
+uint32
+String::hash() const
+{
+  if(isSmall())
+    return hashBytes(small, length());
+  // Racing threads can only ever store the same value here
+  uint32 h = atomicLoadRelaxed(&d->hash);
+  if(!h) {
+    h = hashBytes(d->text, d->length);
+    atomicStoreRelaxed(&d->hash, h);
+  }
+  return h;
+}
+
+bool
+String::operator==(const String &other) const
+{
+  int len = length();
+  if(len != other.length())
+    return false;
+  if(!isSmall() && !other.isSmall()) {
+    if(d == other.d)
+      return true;
+    // Only compare hashes which are already known
+    uint32 h = atomicLoadRelaxed(&d->hash);
+    uint32 otherHash = atomicLoadRelaxed(&other.d->hash);
+    if(h && otherHash && h != otherHash)
+      return false;
+  }
+  return !::memcmp(text(), other.text(), len);
 }
 
 int
@@ -235,10 +323,10 @@ String::parseInt(int &position, int *digits) const
     return 0;
   // TODO:
   // Can we make this not suck for EBCDIC systems? Do we care?
-  if(position < length() && d->text[position] == '-')
+  if(position < length() && text()[position] == '-')
     ++position, neg=true;
-  for( ; position < length() && Char::isAsciiDigit(d->text[position]); ++i )
-    value = (value * radix) + d->text[position++] - '0';
+  for( ; position < length() && Char::isAsciiDigit(text()[position]); ++i )
+    value = (value * radix) + text()[position++] - '0';
   if(digits)
     *digits = i;
   if(neg)
@@ -259,8 +347,8 @@ String::parseUint(int &position, int *digits) const
     return 0;
   // TODO:
   // Can we make this not suck for EBCDIC systems? Do we care?
-  for( ; position < length() && Char::isAsciiDigit(d->text[position]); ++i )
-    value = (value * radix) + d->text[position++] - '0';
+  for( ; position < length() && Char::isAsciiDigit(text()[position]); ++i )
+    value = (value * radix) + text()[position++] - '0';
   if(digits)
     *digits = i;
   return value;
@@ -304,7 +392,7 @@ String::skipWhitespace(int &position) const
   int i = 0;
   if(position < 0 || position >= length())
     return 0;
-  for( ; position < length() && Char::isHtml5Space(d->text[position]); ++i)
+  for( ; position < length() && Char::isHtml5Space(text()[position]); ++i)
     ++position;
   return i;
 }
@@ -314,7 +402,7 @@ String::substring(int position) const
 {
   if(position < 0 || position >= length())
     return String();
-  return String(d->text + position, d->length - position);
+  return String(text() + position, length() - position);
 }
 
 String
@@ -326,18 +414,18 @@ String::substring(int position, int len) const
     return String();
   if(position + len >= length())
     len = length() - position;
-  return String(d->text + position, len);
+  return String(text() + position, len);
 }
 
 bool
 String::collectWord(int &position, char out[], int max) const
 {
   int n = 0;
-  if(isEmpty() || position < 0 || position >= d->length || max <= 0)
+  if(isEmpty() || position < 0 || position >= length() || max <= 0)
     return false;
-  for( ; n < max && position < d->length
-         && !Char::isHtml5Space(d->text[position])
-       ; out[n++] = d->text[position++]);
+  for( ; n < max && position < length()
+         && !Char::isHtml5Space(text()[position])
+       ; out[n++] = text()[position++]);
   if(n < max) {
     out[n] = '\0';
     return true;
@@ -351,23 +439,11 @@ String::skipUntilWhitespace(int &position) const
   int n = 0;
   if(position < 0 || position >= length())
     return 0;
-  for( ; position < length() && !Char::isHtml5Space(d->text[position]);
+  for( ; position < length() && !Char::isHtml5Space(text()[position]);
        ++n, ++position);
   return n;
 }
 
-static inline int
-findChar(const char *bucket0, int bucketLen, char needle, int from)
-{
-  const char *c = ::strchr(bucket0 + from, needle);
-  return c ? c - bucket0 : -1;
-}
-
-#define REHASH(a) \
-  if (sl_minus_1 < (int)sizeof(int) * CHAR_BIT) \
-    hashBucket -= (a) << sl_minus_1; \
-  hashBucket <<= 1
-
 int
 String::findString(const char *bucket0, int bucketLen, int from,
                    const char *needle0, int needleLen)
@@ -383,41 +459,16 @@ String::findString(const char *bucket0, int bucketLen, int from,
   if (!l)
     return -1;
 
-  if (sl == 1)
-    return findChar(bucket0, bucketLen, needle0[0], from);
-
-  // We use the Boyer-Moore algorithm in cases where the overhead
-  // for the skip table should pay off, otherwise we use a simple
-  // hash function.
+#if !defined(TT_HAVE_SSE2)
+  // Without SIMD, we use the Boyer-Moore algorithm in cases where the
+  // overhead for the skip table should pay off.
   if (l > 500 && sl > 5)
     return findStringBoyerMoore(bucket0, bucketLen, from,
                                 needle0, needleLen);
+#endif
 
-  // We use some hashing for efficiency's sake. Instead of
-  // comparing strings, we compare the hash value of str with that
-  // of a part of this QString. Only if that matches, we call
-  // ucstrncmp() or ucstrnicmp().
-  const char *needle = (const char *)needle0;
-  const char *bucket = (const char *)bucket0 + from;
-  const char *end = (const char *)bucket0 + (l-sl);
-  const int sl_minus_1 = sl-1;
-  int hashNeedle = 0, hashBucket = 0, idx;
-
-  for (idx = 0; idx < sl; ++idx) {
-    hashNeedle = ((hashNeedle<<1) + needle[idx]);
-    hashBucket = ((hashBucket<<1) + bucket[idx]);
-  }
-  hashBucket -= bucket[sl_minus_1];
-
-  while (bucket <= end) {
-    hashBucket += bucket[sl_minus_1];
-    if (hashBucket == hashNeedle && strncmp(needle, bucket, sl) == 0)
-      return bucket - bucket0;
-
-    REHASH(*bucket);
-    ++bucket;
-  }
-  return -1;
+  int idx = findBytes(bucket0 + from, l - from, needle0, sl);
+  return idx < 0 ? -1 : idx + from;
 }
 
 void
@@ -486,7 +537,9 @@ StringMatcher::StringMatcher(const char *str, int len)
 {
   search = str;
   searchLen = len;
+#if !defined(TT_HAVE_SSE2)
   bm_init_skiptable(str, len, skiptable);
+#endif
 }
 
 StringMatcher::~StringMatcher()
@@ -499,7 +552,14 @@ StringMatcher::findIn(const char *str, int len, int from)
 {
   if(from < 0)
     from = 0;
+#if defined(TT_HAVE_SSE2)
+  if(from > len)
+    return -1;
+  int idx = findBytes(str + from, len - from, search, searchLen);
+  return idx < 0 ? -1 : idx + from;
+#else
   return bm_find(str, len, from, search, searchLen, skiptable);
+#endif
 }
 
 }
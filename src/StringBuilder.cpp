@@ -29,11 +29,12 @@
 #include "StringData.h"
 #include "Utility.h"
 #include <cstdlib>
+#include <cstddef>
 
 namespace TimedText
 {
 
-StringBuilder::Data StringBuilder::empty = { 0, 0, { '\0' } };
+StringBuilder::Data StringBuilder::empty = { 0, 0, 0, { '\0' } };
 
 StringBuilder::StringBuilder()
   : d(&empty)
@@ -61,7 +62,8 @@ bool
 StringBuilder::reallocData(int alloc, bool grow)
 {
   if(grow)
-    alloc = allocMore(alloc,sizeof(Data));
+    // Grow in steps sized by the header alone, ignoring padding after it
+    alloc = allocMore(alloc,offsetof(Data, text));
   Data *x = Data::allocate(d, alloc);
   if(!x) {
     if(!d)
@@ -163,7 +165,58 @@ StringBuilder::indexOf(uint32 ucs4, int from) const
 bool StringBuilder::toString(String &result) const
 {
   result = String(d->text,d->length);
-  return result.d->length==d->length;
+  return result.length()==d->length;
+}
+
+bool
+StringBuilder::takeString(String &result, bool reuse)
+{
+  // The ref count takes the place of alloc, and hash that of reserved, so
+  // Data must match String::Data member for member after that.
+  enum { SameLayout = sizeof(AtomicInt) == sizeof(int) };
+  typedef char CheckLayout[!SameLayout ||
+    (offsetof(Data, length) == offsetof(String::Data, length) &&
+     offsetof(Data, reserved) == offsetof(String::Data, hash) &&
+     offsetof(Data, text) == offsetof(String::Data, text) &&
+     sizeof(Data) == sizeof(String::Data)) ? 1 : -1];
+  (void)sizeof(CheckLayout);
+
+  // The text is already valid UTF-8, so it need not be checked again.
+  const int len = d->length;
+  if(len <= String::SmallCapacity || !SameLayout) {
+    // Short text is copied to inline storage, and the builder keeps its
+    // buffer for reuse.
+    String str;
+    char *out = str.allocate(len);
+    if(!out)
+      return false;
+    ::memcpy(out, d->text, len);
+    result = str;
+    clear();
+    return true;
+  }
+
+  Data *x = d;
+  d = &empty;
+  if(reuse) {
+    // Start over with a buffer as large as the one given away, rather
+    // than growing a new one step by step for the next text.
+    Data *y = Data::allocate(0, x->alloc);
+    if(y)
+      d = y;
+  }
+  if(x->alloc - len > len) {
+    // Give back a mostly unused buffer, which should not need to move
+    Data *y = static_cast<Data *>(::realloc(x, sizeof(Data) + len));
+    if(y)
+      x = y;
+  }
+  String::Data *s = reinterpret_cast<String::Data *>(x);
+  s->ref = 0;
+  s->length = len;
+  s->hash = 0;
+  result = String(*s);
+  return true;
 }
 
 void
@@ -220,12 +273,25 @@ StringBuilder::append(const char *utf8, int len)
     len = ::strlen(utf8);
   if(len == 0)
     return true;
-  int vlen = Unicode::utf8Length(utf8, len);
-  if(length() + vlen >= capacity() && !reallocData(length() + vlen, true))
+  // Text is nearly always valid, in which case it is copied as is.
+  if(length() + len >= capacity() && !reallocData(length() + len, true))
     return false;
-
-  Unicode::toValidUtf8(d->text + d->length, capacity(), vlen, utf8, len);
-  d->length += vlen;
+  int valid = Unicode::copyValidUtf8(d->text + d->length, utf8, len);
+  d->length += valid;
+  if(valid < len) {
+    // Otherwise, replacing the invalid sequences may lengthen it.
+    utf8 += valid;
+    len -= valid;
+    int vlen = Unicode::utf8Length(utf8, len);
+    if(length() + vlen >= capacity()
+       && !reallocData(length() + vlen, true)) {
+      d->text[d->length] = '\0';
+      return false;
+    }
+    Unicode::toValidUtf8(d->text + d->length, capacity() - d->length, vlen,
+                         utf8, len);
+    d->length += vlen;
+  }
   d->text[d->length] = '\0';
   // Should we return false if the UTF8 is not valid?
   return true;
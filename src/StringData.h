@@ -38,6 +38,8 @@ struct String::Data
 {
   AtomicInt ref;
   int length;
+  // Cached String::hash(), or 0 if not yet computed
+  uint32 hash;
   char text[1];
 };
 
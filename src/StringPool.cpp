@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#include <TimedText/StringPool.h>
+#include "HashChains.h"
+#include "StringData.h"
+#include "Utility.h"
+#include <cstdlib>
+
+namespace TimedText
+{
+
+struct StringPool::Entry
+{
+  uint32 hash;
+  String text;
+  Entry *next;
+};
+
+StringPool::StringPool(int capacity)
+  : buckets(0), numBuckets(0), numEntries(0),
+    maxEntries(capacity > 0 ? capacity : 1), evictCursor(0)
+{
+}
+
+StringPool::~StringPool()
+{
+  clear();
+  ::free(buckets);
+}
+
+bool
+StringPool::intern(const char *text, int len, String &result)
+{
+  if(!text) {
+    result = String();
+    return true;
+  }
+  if(len < 0)
+    len = ::strlen(text);
+
+  uint32 hash = hashBytes(text, len);
+  if(numEntries) {
+    for(Entry *e = hashBucket(buckets, numBuckets, hash); e; e = e->next) {
+      if(e->hash == hash && e->text.length() == len
+         && !::memcmp(e->text.text(), text, len)) {
+        result = e->text;
+        return true;
+      }
+    }
+  }
+
+  // Pooled text is always kept in a shared buffer, even when it would fit
+  // inline, so that every String returned for it has the same text().
+  String::Data *x = static_cast<String::Data *>(
+    ::malloc(sizeof(String::Data) + len));
+  if(!x)
+    return false;
+  if(Unicode::copyValidUtf8(x->text, text, len) != len) {
+    // Text which is not valid UTF-8 is altered when the String is built,
+    // and could never be found again by its original bytes.
+    ::free(x);
+    result = String(text, len);
+    return !result.isNull();
+  }
+  x->ref = 0;
+  x->length = len;
+  x->hash = hash;
+  x->text[len] = '\0';
+  String str(*x);
+  result = str;
+
+  if(numEntries >= maxEntries) {
+    // Make room by dropping a single String, rather than all of them
+    delete evictEntry(buckets, numBuckets, evictCursor);
+    --numEntries;
+  }
+  if(!reserveBuckets(buckets, numBuckets, numEntries, 8,
+                     HashEntryPointers<Entry>()))
+    return true;
+  Entry *e = new Entry;
+  if(!e)
+    return true;
+  e->hash = hash;
+  e->text = str;
+  linkEntry(buckets, numBuckets, e, HashEntryPointers<Entry>());
+  ++numEntries;
+  return true;
+}
+
+void
+StringPool::clear()
+{
+  for(int i=0; i<numBuckets; ++i) {
+    Entry *e = buckets[i];
+    while(e) {
+      Entry *next = e->next;
+      delete e;
+      e = next;
+    }
+    buckets[i] = 0;
+  }
+  numEntries = 0;
+}
+
+} // TimedText
@@ -0,0 +1,218 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/TimeTransform.h>
+
+namespace TimedText
+{
+
+TimeTransform::TimeTransform()
+  : num(1), den(1), offset(0), first(0), last(maxTime())
+{
+}
+
+bool
+TimeTransform::setScale(int numerator, int denominator)
+{
+  if(numerator <= 0 || denominator <= 0)
+    return false;
+  num = numerator;
+  den = denominator;
+  return true;
+}
+
+void
+TimeTransform::setOffset(Milliseconds ms)
+{
+  // Keeps 'last - offset' and 'first - offset' within range in shift()
+  Milliseconds limit = maxTime() - 1;
+  offset = ms > limit ? limit : ms < -limit ? -limit : ms;
+}
+
+void
+TimeTransform::setWindow(Milliseconds from, Milliseconds to)
+{
+  if(from < 0)
+    from = 0;
+  if(to > maxTime())
+    to = maxTime();
+  if(to < from)
+    to = from;
+  first = from;
+  last = to;
+}
+
+Timestamp
+TimeTransform::apply(const Timestamp &time) const
+{
+  Milliseconds ms = time;
+  apply(&ms, 1);
+  return Timestamp(ms);
+}
+
+void
+TimeTransform::apply(Milliseconds *times, int count) const
+{
+  if(num == den)
+    shift(times, count);
+  else
+    scaleAndShift(times, count);
+}
+
+// Clamping is done before the offset is added rather than after, against a
+// window moved by -offset, so the addition cannot overflow. The selects
+// below compile to conditional moves, or to blends where the target has
+// 64-bit vector compares.
+void
+TimeTransform::shift(Milliseconds *times, int count) const
+{
+  Milliseconds lo = first - offset;
+  Milliseconds hi = last - offset;
+  Milliseconds add = offset;
+  for(int i = 0; i < count; ++i) {
+    Milliseconds t = times[i];
+    Milliseconds v = t < lo ? lo : t;
+    v = v > hi ? hi : v;
+    times[i] = t < 0 ? t : v + add;
+  }
+}
+
+// t * num / den is computed as (t / den) * num + (t % den) * num / den, so
+// no intermediate value exceeds 2^62 and the result is exact. Times whose
+// product would be larger than maxTime() saturate to it instead.
+void
+TimeTransform::scaleAndShift(Milliseconds *times, int count) const
+{
+  uint64 n = uint64(num);
+  uint64 d = uint64(den);
+  uint64 half = d / 2;
+  uint64 limit = uint64(maxTime()) / n;
+  Milliseconds lo = first - offset;
+  Milliseconds hi = last - offset;
+  Milliseconds add = offset;
+  for(int i = 0; i < count; ++i) {
+    Milliseconds t = times[i];
+    uint64 u = uint64(t);
+    uint64 q = u / d;
+    uint64 r = u - q * d;
+    Milliseconds v = q > limit ? maxTime()
+                               : Milliseconds(q * n + (r * n + half) / d);
+    v = v < lo ? lo : v;
+    v = v > hi ? hi : v;
+    times[i] = t < 0 ? t : v + add;
+  }
+}
+
+// The tree is walked through the const iterators, so that nothing is
+// copied while looking for timestamps. When one is to change, the path down
+// to it is taken again through the non-const iterators, which copy the
+// shared branches on that path alone, and the walk goes on through those
+// copies.
+bool
+TimeTransform::apply(Node &tree) const
+{
+  if(tree.element() == TimestampNode)
+    return tree.setTimestamp(apply(tree.timestamp()));
+
+  List<const Node *> branches;
+  List<int> positions;
+  if(!branches.push(&tree) || !positions.push(0))
+    return false;
+  while(!branches.isEmpty()) {
+    int top = branches.count() - 1;
+    const Node *branch = branches[top];
+    int i = positions[top];
+    if(i < branch->childCount()) {
+      positions[top] = i + 1;
+      const Node &child = branch->begin()[i];
+      if(child.element() == TimestampNode) {
+        Timestamp ts = child.timestamp();
+        Timestamp result = apply(ts);
+        if(Milliseconds(result) == Milliseconds(ts))
+          continue;
+        // Each level's position is one past the child being visited
+        Node *node = &tree;
+        for(int k = 0; k <= top; ++k) {
+          node = &node->begin()[positions[k] - 1];
+          if(k < top)
+            branches[k + 1] = node;
+        }
+        if(!node->setTimestamp(result))
+          return false;
+      } else if(child.type() == InternalNode && child.childCount() > 0) {
+        if(!branches.push(&child))
+          return false;
+        if(!positions.push(0)) {
+          branches.pop();
+          return false;
+        }
+      }
+    } else {
+      branches.pop();
+      positions.pop();
+    }
+  }
+  return true;
+}
+
+bool
+TimeTransform::applyToNodes(Cue &cue) const
+{
+  Node tree;
+  if(!cue.nodes(tree) || tree.type() == EmptyNode)
+    return true;
+  // 'tree' shares its data with the cue, so apply() copies it if there is
+  // anything to change, and only then is it stored again.
+  Node old = tree;
+  if(!apply(tree))
+    return false;
+  return tree == old || cue.setNodes(tree);
+}
+
+bool
+TimeTransform::apply(Cue &cue) const
+{
+  if(isIdentity())
+    return true;
+  cue.setStartTime(apply(cue.startTime()));
+  cue.setEndTime(apply(cue.endTime()));
+  return applyToNodes(cue);
+}
+
+bool
+TimeTransform::apply(List<Cue> &cues) const
+{
+  if(isIdentity())
+    return true;
+  for(List<Cue>::iterator it = cues.begin(); it != cues.end(); ++it) {
+    if(!apply(*it))
+      return false;
+  }
+  return true;
+}
+
+} // TimedText
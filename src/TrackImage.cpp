@@ -0,0 +1,565 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/TrackImage.h>
+#include <TimedText/WebVTTParser.h>
+#include "PackedCueSettings.h"
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+namespace TimedText
+{
+
+static const char imageMagic[4] = { 'T', 'T', 'I', 'M' };
+static const uint32 imageByteOrder = 0x01020304;
+static const uint32 nullString = 0xffffffff;
+
+enum
+{
+  HasNodesFlag = 0x1
+};
+
+// All offsets are in bytes, from the start of the image, except for those
+// into the text, node and node text areas, which are from the start of
+// those areas.
+struct TrackImage::Header
+{
+  char magic[4];
+  uint32 version;
+  uint32 byteOrder;
+  uint32 flags;
+  uint32 count;
+  uint32 size;
+  // Milliseconds[count]
+  uint32 starts;
+  uint32 ends;
+  // PackedCueSettings[count]
+  uint32 settings;
+  // uint32[2 * count + 1], as in CueStore
+  uint32 textOffsets;
+  uint32 text;
+  uint32 textSize;
+  // uint32[count + 1], the extent of each cue's records in the node area
+  uint32 nodeOffsets;
+  uint32 nodes;
+  uint32 nodesSize;
+  // Text, voices, languages and classes of nodes
+  uint32 nodeText;
+  uint32 nodeTextSize;
+  // Pads the header to a multiple of 8 bytes
+  uint32 reserved;
+};
+
+// Trees of nodes are stored as records in pre-order. A record is followed
+// by 'classCount' StringRefs for its applicable classes.
+struct NodeRecord
+{
+  uint8 element;
+  uint8 reserved;
+  uint16 classCount;
+  uint32 childCount;
+  // Text, voice or language of the node, or the two halves of the time of
+  // a TimestampNode
+  uint32 offset;
+  uint32 length;
+};
+
+struct StringRef
+{
+  uint32 offset;
+  uint32 length;
+};
+
+TrackImage::TrackImage()
+  : header(0), base(0)
+{
+}
+
+static inline bool
+validSection(uint32 offset, uint64 length, uint32 align, uint32 size)
+{
+  return !(offset & (align - 1)) && offset + length <= uint64(size);
+}
+
+bool
+TrackImage::open(const void *data, int size)
+{
+  close();
+  if(!data || size < int(sizeof(Header)) || (uintptr(data) & 7))
+    return false;
+  const Header *h = static_cast<const Header *>(data);
+  if(::memcmp(h->magic, imageMagic, sizeof(imageMagic))
+     || h->version != Version || h->byteOrder != imageByteOrder
+     || h->size > uint32(size) || h->size < sizeof(Header))
+    return false;
+  uint64 n = h->count;
+  if(!validSection(h->starts, n * sizeof(Milliseconds), 8, h->size)
+     || !validSection(h->ends, n * sizeof(Milliseconds), 8, h->size)
+     || !validSection(h->settings, n * sizeof(PackedCueSettings), 8, h->size)
+     || !validSection(h->textOffsets, (2 * n + 1) * 4, 4, h->size)
+     || !validSection(h->text, h->textSize, 1, h->size))
+    return false;
+  if((h->flags & HasNodesFlag)
+     && (!validSection(h->nodeOffsets, (n + 1) * 4, 4, h->size)
+         || !validSection(h->nodes, h->nodesSize, 4, h->size)
+     || !validSection(h->nodeText, h->nodeTextSize, 1, h->size)))
+    return false;
+  header = h;
+  base = static_cast<const char *>(data);
+  return true;
+}
+
+void
+TrackImage::close()
+{
+  header = 0;
+  base = 0;
+}
+
+int
+TrackImage::count() const
+{
+  return header ? int(header->count) : 0;
+}
+
+bool
+TrackImage::hasNodes() const
+{
+  return header && (header->flags & HasNodesFlag);
+}
+
+const Milliseconds *
+TrackImage::startTimes() const
+{
+  return header
+    ? reinterpret_cast<const Milliseconds *>(base + header->starts) : 0;
+}
+
+const Milliseconds *
+TrackImage::endTimes() const
+{
+  return header
+    ? reinterpret_cast<const Milliseconds *>(base + header->ends) : 0;
+}
+
+const PackedCueSettings *
+TrackImage::settings() const
+{
+  return reinterpret_cast<const PackedCueSettings *>(base + header->settings);
+}
+
+bool
+TrackImage::stringAt(uint32 area, uint32 areaSize, uint32 offset,
+                     uint32 length, String &result) const
+{
+  if(offset == nullString) {
+    result = String();
+    return true;
+  }
+  if(uint64(offset) + length > areaSize || length > INT_MAX)
+    return false;
+  result = String(base + area + offset, int(length));
+  return true;
+}
+
+String
+TrackImage::id(int i) const
+{
+  String result;
+  if(header && i >= 0 && i < count()) {
+    const uint32 *offsets =
+      reinterpret_cast<const uint32 *>(base + header->textOffsets);
+    uint32 from = offsets[2 * i], to = offsets[2 * i + 1];
+    if(!(settings()[i].flags & PackedCueSettings::NullIdFlag)
+       && from <= to && to <= header->textSize)
+      stringAt(header->text, header->textSize, from, to - from, result);
+  }
+  return result;
+}
+
+String
+TrackImage::text(int i) const
+{
+  String result;
+  if(header && i >= 0 && i < count()) {
+    const uint32 *offsets =
+      reinterpret_cast<const uint32 *>(base + header->textOffsets);
+    uint32 from = offsets[2 * i + 1], to = offsets[2 * i + 2];
+    if(!(settings()[i].flags & PackedCueSettings::NullTextFlag)
+       && from <= to && to <= header->textSize)
+      stringAt(header->text, header->textSize, from, to - from, result);
+  }
+  return result;
+}
+
+bool
+TrackImage::cueAt(int i, Cue &result) const
+{
+  if(i < 0 || i >= count())
+    return false;
+  const PackedCueSettings &s = settings()[i];
+  Cue cue(CueType(s.type), startTime(i), endTime(i), id(i), text(i));
+  s.apply(cue);
+  Node tree;
+  if(hasNodes() && nodes(i, tree))
+    cue.setNodes(tree);
+  result = cue;
+  return true;
+}
+
+bool
+TrackImage::nodes(int i, Node &result) const
+{
+  if(!hasNodes() || i < 0 || i >= count())
+    return false;
+  const uint32 *offsets =
+    reinterpret_cast<const uint32 *>(base + header->nodeOffsets);
+  uint32 from = offsets[i], to = offsets[i + 1];
+  if(from >= to || to > header->nodesSize || (from & 3))
+    return false;
+  const char *p = base + header->nodes + from;
+  const char *end = base + header->nodes + to;
+
+  // Nodes with children are held here until all of their children have
+  // been added, since adding to a shared Node would copy it.
+  List<Node> parents;
+  List<int> remaining;
+  while(end - p >= int(sizeof(NodeRecord))) {
+    NodeRecord record;
+    ::memcpy(&record, p, sizeof(NodeRecord));
+    p += sizeof(NodeRecord);
+    if(record.element >= LastNodeElementType
+       || record.childCount > uint32(end - p) / sizeof(NodeRecord)
+       || record.classCount > uint32(end - p) / sizeof(StringRef))
+      return false;
+
+    Node node;
+    if(record.element != NullNode)
+      node = Node(NodeElementType(record.element));
+    String str;
+    if(record.element == TimestampNode) {
+      node.setTimestamp(Timestamp(Milliseconds(
+        (uint64(record.length) << 32) | record.offset)));
+    } else if(record.element == TextNode || record.element == VoiceNode
+              || record.element == LangNode) {
+      if(!stringAt(header->nodeText, header->nodeTextSize, record.offset,
+                   record.length, str))
+        return false;
+      if(record.element == TextNode)
+        node.setText(str);
+      else if(record.element == VoiceNode)
+        node.setVoice(str);
+      else
+        node.setLang(str);
+    }
+    if(record.classCount) {
+      List<String> classes;
+      for(int j = 0; j < record.classCount; ++j) {
+        StringRef ref;
+        ::memcpy(&ref, p, sizeof(StringRef));
+        p += sizeof(StringRef);
+        if(!stringAt(header->nodeText, header->nodeTextSize, ref.offset,
+                     ref.length, str) || !classes.push(str))
+          return false;
+      }
+      node.setApplicableClasses(classes);
+    }
+
+    if(record.childCount) {
+      if(!parents.push(node) || !remaining.push(int(record.childCount)))
+        return false;
+      continue;
+    }
+    // Add each completed node to its parent, which may complete the parent
+    for(;;) {
+      if(parents.isEmpty()) {
+        result = node;
+        return p == end;
+      }
+      int top = parents.count() - 1;
+      if(!parents[top].push(node))
+        return false;
+      if(--remaining[top])
+        break;
+      parents.pop(node);
+      remaining.pop();
+    }
+  }
+  return false;
+}
+
+// Growable byte array for building images
+struct ImageBuffer
+{
+  ImageBuffer() : data(0), size(0), alloc(0) {}
+  ~ImageBuffer() { ::free(data); }
+
+  bool append(const void *bytes, int len) {
+    if(len > INT_MAX - size)
+      return false;
+    if(size + len > alloc) {
+      int n = alloc ? alloc : 256;
+      while(n < size + len)
+        n = n > INT_MAX / 2 ? INT_MAX : n * 2;
+      char *x = static_cast<char *>(::realloc(data, n));
+      if(!x)
+        return false;
+      data = x;
+      alloc = n;
+    }
+    ::memcpy(data + size, bytes, len);
+    size += len;
+    return true;
+  }
+
+  // Offset of 'str' once appended, or nullString
+  bool appendString(const String &str, uint32 &offset) {
+    if(str.isNull()) {
+      offset = nullString;
+      return true;
+    }
+    offset = uint32(size);
+    return append(str.text(), str.length());
+  }
+
+  char *data;
+  int size;
+  int alloc;
+};
+
+static bool
+writeNode(const Node &node, ImageBuffer &nodes, ImageBuffer &text)
+{
+  NodeRecord record;
+  ::memset(&record, 0, sizeof(NodeRecord));
+  record.element = uint8(node.element());
+  record.childCount = uint32(node.childCount());
+  String str;
+  switch(node.element()) {
+    case TimestampNode: {
+      uint64 ms = uint64(Milliseconds(node.timestamp()));
+      record.offset = uint32(ms);
+      record.length = uint32(ms >> 32);
+      break;
+    }
+    case TextNode: str = node.text(); break;
+    case VoiceNode: str = node.voice(); break;
+    case LangNode: str = node.lang(); break;
+    default: break;
+  }
+  if(!str.isNull()) {
+    if(!text.appendString(str, record.offset))
+      return false;
+    record.length = uint32(str.length());
+  }
+  List<String> classes;
+  if(node.type() == InternalNode)
+    classes = node.applicableClasses();
+  if(classes.count() > 0xffff)
+    return false;
+  record.classCount = uint16(classes.count());
+  if(!nodes.append(&record, sizeof(NodeRecord)))
+    return false;
+  for(int i = 0; i < classes.count(); ++i) {
+    StringRef ref;
+    if(!text.appendString(classes[i], ref.offset))
+      return false;
+    ref.length = uint32(classes[i].length());
+    if(!nodes.append(&ref, sizeof(StringRef)))
+      return false;
+  }
+  return true;
+}
+
+// Write 'root' and its descendants in pre-order, see traverse()
+static bool
+writeTree(const Node &root, ImageBuffer &nodes, ImageBuffer &text)
+{
+  if(!writeNode(root, nodes, text))
+    return false;
+  List<Node> branches;
+  List<int> positions;
+  if(root.childCount() && (!branches.push(root) || !positions.push(0)))
+    return false;
+  while(!branches.isEmpty()) {
+    int top = branches.count() - 1;
+    const List<Node> &children = branches[top].children();
+    int i = positions[top];
+    if(i < children.count()) {
+      Node child;
+      children.itemAt(i, child);
+      ++positions[top];
+      if(!writeNode(child, nodes, text))
+        return false;
+      if(child.childCount() && (!branches.push(child) || !positions.push(0)))
+        return false;
+    } else {
+      branches.pop();
+      positions.pop();
+    }
+  }
+  return true;
+}
+
+static inline uint64
+alignTo8(uint64 offset)
+{
+  return (offset + 7) & ~uint64(7);
+}
+
+TrackImageWriter::TrackImageWriter()
+  : image(0), imageSize(0)
+{
+}
+
+TrackImageWriter::~TrackImageWriter()
+{
+  clear();
+}
+
+void
+TrackImageWriter::clear()
+{
+  ::free(image);
+  image = 0;
+  imageSize = 0;
+}
+
+bool
+TrackImageWriter::write(const List<Cue> &cues, int flags)
+{
+  clear();
+  typedef TrackImage::Header Header;
+  uint64 n = uint64(cues.count());
+  bool withNodes = !!(flags & IncludeNodes);
+
+  // Text and node trees are collected first, since their sizes are not
+  // known until then
+  ImageBuffer text, nodes, nodeText;
+  uint32 *textOffsets = static_cast<uint32 *>(
+    ::malloc((2 * n + 1) * sizeof(uint32)));
+  uint32 *nodeOffsets = static_cast<uint32 *>(
+    ::malloc((n + 1) * sizeof(uint32)));
+  PackedCueSettings *settings = static_cast<PackedCueSettings *>(
+    ::malloc((n ? n : 1) * sizeof(PackedCueSettings)));
+  bool ok = textOffsets && nodeOffsets && settings;
+  Cue cue;
+  if(ok) {
+    textOffsets[0] = 0;
+    nodeOffsets[0] = 0;
+  }
+  for(int i = 0; ok && i < cues.count(); ++i) {
+    cues.itemAt(i, cue);
+    String id = cue.id();
+    String str = cue.text();
+    settings[i].pack(cue);
+    if(id.isNull())
+      settings[i].flags |= PackedCueSettings::NullIdFlag;
+    if(str.isNull())
+      settings[i].flags |= PackedCueSettings::NullTextFlag;
+    ok = text.append(id.text(), id.length());
+    textOffsets[2 * i + 1] = uint32(text.size);
+    ok = ok && text.append(str.text(), str.length());
+    textOffsets[2 * i + 2] = uint32(text.size);
+    if(ok && withNodes) {
+      Node tree;
+      if((!cue.nodes(tree) || tree.type() == EmptyNode)
+         && cue.type() == WebVTTCue)
+        WebVTTParser::cuetextToNodes(str, tree);
+      if(tree.type() != EmptyNode)
+        ok = writeTree(tree, nodes, nodeText);
+      nodeOffsets[i + 1] = uint32(nodes.size);
+    }
+  }
+
+  Header header;
+  ::memset(&header, 0, sizeof(Header));
+  uint64 offset = sizeof(Header);
+  header.starts = uint32(offset);
+  offset += n * sizeof(Milliseconds);
+  header.ends = uint32(offset);
+  offset += n * sizeof(Milliseconds);
+  header.settings = uint32(offset);
+  offset += n * sizeof(PackedCueSettings);
+  header.textOffsets = uint32(offset);
+  offset = alignTo8(offset + (2 * n + 1) * sizeof(uint32));
+  header.text = uint32(offset);
+  header.textSize = uint32(text.size);
+  offset = alignTo8(offset + uint64(text.size));
+  if(withNodes) {
+    header.flags |= HasNodesFlag;
+    header.nodeOffsets = uint32(offset);
+    offset = alignTo8(offset + (n + 1) * sizeof(uint32));
+    header.nodes = uint32(offset);
+    header.nodesSize = uint32(nodes.size);
+    offset += uint64(nodes.size);
+    header.nodeText = uint32(offset);
+    header.nodeTextSize = uint32(nodeText.size);
+    offset += uint64(nodeText.size);
+  }
+  ok = ok && offset <= uint64(INT_MAX);
+  if(ok)
+    image = static_cast<char *>(::calloc(size_t(offset), 1));
+  if(ok && image) {
+    ::memcpy(header.magic, imageMagic, sizeof(imageMagic));
+    header.version = TrackImage::Version;
+    header.byteOrder = imageByteOrder;
+    header.count = uint32(n);
+    header.size = uint32(offset);
+    ::memcpy(image, &header, sizeof(Header));
+    Milliseconds *starts =
+      reinterpret_cast<Milliseconds *>(image + header.starts);
+    Milliseconds *ends = reinterpret_cast<Milliseconds *>(image + header.ends);
+    for(int i = 0; i < cues.count(); ++i) {
+      cues.itemAt(i, cue);
+      starts[i] = cue.startTime();
+      ends[i] = cue.endTime();
+    }
+    ::memcpy(image + header.settings, settings,
+             n * sizeof(PackedCueSettings));
+    ::memcpy(image + header.textOffsets, textOffsets,
+             (2 * n + 1) * sizeof(uint32));
+    if(text.size)
+      ::memcpy(image + header.text, text.data, text.size);
+    if(withNodes) {
+      ::memcpy(image + header.nodeOffsets, nodeOffsets,
+               (n + 1) * sizeof(uint32));
+      if(nodes.size)
+        ::memcpy(image + header.nodes, nodes.data, nodes.size);
+      if(nodeText.size)
+        ::memcpy(image + header.nodeText, nodeText.data, nodeText.size);
+    }
+    imageSize = int(offset);
+  }
+  ::free(textOffsets);
+  ::free(nodeOffsets);
+  ::free(settings);
+  return imageSize != 0;
+}
+
+} // TimedText
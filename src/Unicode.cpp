@@ -27,6 +27,7 @@
 
 #include <TimedText/Unicode.h>
 #include <TimedText/String.h>
+#include "Utility.h"
 #include <cstring>
 
 namespace TimedText
@@ -199,6 +200,170 @@ Unicode::toValidUtf8(char *out, int alloc, int &olen,
   return true;
 }
 
+int
+Unicode::copyValidUtf8(char *out, const char *in, int len)
+{
+  int i = 0;
+  while(i < len) {
+#if defined(TT_HAVE_SSE2)
+    // Copy ASCII 32 bytes at a time, and then up to the first non-ASCII byte
+    // of the following 16.
+    while(len - i >= 32) {
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+      __m128i b = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(in + i + 16));
+      if(_mm_movemask_epi8(_mm_or_si128(a, b)))
+        break;
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), a);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 16), b);
+      i += 32;
+    }
+    if(len - i >= 16) {
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+      unsigned mask = unsigned(_mm_movemask_epi8(a));
+      if(!mask) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), a);
+        i += 16;
+        continue;
+      }
+      int n = countTrailingZeros(mask);
+      ::memcpy(out + i, in + i, n);
+      i += n;
+    }
+    // The block loop may have consumed the rest of the input
+    if(i >= len)
+      break;
+#endif
+    char c = in[i];
+    if(utf8IsSingle(c)) {
+      out[i++] = c;
+      continue;
+    }
+    if(!utf8IsLead(c))
+      return i;
+    int t = utf8NumTrailBytes(c);
+    if(t >= len - i)
+      return i;
+    utf8MaskLeadByte(c,t);
+    uint32 uc = c & 0xFF;
+    for(int j=1; j<=t; ++j) {
+      char next = in[i + j];
+      if(!utf8IsTrail(next))
+        return i;
+      uc = ((uc << 6) | (next & 0x3F));
+    }
+    // Overlong forms are left for toValidUtf8() to deal with
+    if(!isChar(uc) || utf8Length(uc) != t + 1)
+      return i;
+    ::memcpy(out + i, in + i, t + 1);
+    i += t + 1;
+  }
+  return i;
+}
+
+int
+Unicode::utf16Length(const char *utf8, int len)
+{
+  if(!utf8)
+    return 0;
+  if(len < 0)
+    len = ::strlen(utf8);
+  int n = 0;
+  int i = 0;
+#if defined(TT_HAVE_SSE2)
+  for( ; len - i >= 16; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(utf8 + i));
+    if(!_mm_movemask_epi8(v)) {
+      n += 16;
+      continue;
+    }
+    for(int j=i; j<i+16; ++j) {
+      uchar c = uchar(utf8[j]);
+      // One unit per character, and another for a 4-byte sequence, which
+      // needs a surrogate pair
+      n += (c & 0xC0) != 0x80;
+      n += c >= 0xF0;
+    }
+  }
+#endif
+  for( ; i < len; ++i) {
+    uchar c = uchar(utf8[i]);
+    n += (c & 0xC0) != 0x80;
+    n += c >= 0xF0;
+  }
+  return n;
+}
+
+bool
+Unicode::toUtf16(uint16 *out, int alloc, int &olen, const char *in, int len)
+{
+  olen = 0;
+  if(!in || !out)
+    return false;
+  if(len < 0)
+    len = ::strlen(in);
+  int i = 0;
+  int o = 0;
+  while(i < len) {
+#if defined(TT_HAVE_SSE2)
+    // Widen ASCII 16 bytes at a time, up to the first non-ASCII byte
+    const __m128i zero = _mm_setzero_si128();
+    while(len - i >= 16 && alloc - o >= 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+      unsigned mask = unsigned(_mm_movemask_epi8(v));
+      if(mask) {
+        for(int n = countTrailingZeros(mask); n > 0; --n)
+          out[o++] = uchar(in[i++]);
+        break;
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + o),
+                       _mm_unpacklo_epi8(v, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + o + 8),
+                       _mm_unpackhi_epi8(v, zero));
+      i += 16;
+      o += 16;
+    }
+    if(i >= len)
+      break;
+#endif
+    char c = in[i++];
+    uint32 uc;
+    if(utf8IsSingle(c)) {
+      uc = uchar(c);
+    } else if(utf8IsLead(c)) {
+      int t = utf8NumTrailBytes(c);
+      utf8MaskLeadByte(c,t);
+      uc = uchar(c);
+      for(int j=0; j<t; ++j) {
+        if(i >= len || !utf8IsTrail(in[i])) {
+          uc = 0xFFFD;
+          break;
+        }
+        uc = ((uc << 6) | (in[i++] & 0x3F));
+      }
+    } else {
+      uc = 0xFFFD;
+    }
+    if(uc >= 0x10000 && uc <= CodepointLimit) {
+      if(alloc - o < 2) {
+        olen = o;
+        return false;
+      }
+      uc -= 0x10000;
+      out[o++] = uint16(HighSurrogateBegin + (uc >> 10));
+      out[o++] = uint16(LowSurrogateBegin + (uc & 0x3FF));
+    } else {
+      if(o >= alloc) {
+        olen = o;
+        return false;
+      }
+      out[o++] = uint16(uc <= CodepointLimit ? uc : 0xFFFD);
+    }
+  }
+  olen = o;
+  return true;
+}
+
 uint32
 Unicode::utf8ToUCS4(const char *text, int len, int &position)
 {
@@ -213,7 +378,7 @@ Unicode::utf8ToUCS4(const char *text, int len, int &position)
     return uint32(c);
   if(utf8IsLead(c)) {
     int n = utf8NumTrailBytes(c);
-    if(position + n >= len)
+    if(position + n > len)
       return uint32(-1);
     utf8MaskLeadByte(c, n);
     uint32 uc = c;
@@ -227,7 +392,7 @@ Unicode::utf8ToUCS4(const char *text, int len, int &position)
     }
     return uc;
   }
-  while(utf8IsTrail(text[position]))
+  while(position < len && utf8IsTrail(text[position]))
     ++position;
   return 0xFFFD;
 }
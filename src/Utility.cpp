@@ -26,6 +26,7 @@
 //
 
 #include "Utility.h"
+#include <cstring>
 
 namespace TimedText
 {
@@ -52,5 +53,115 @@ allocMore(int alloc, int extra)
   return n - extra;
 }
 
+uint32
+hashBytes(const char *data, int len)
+{
+  uint32 h = 2166136261u;
+  for(int i=0; i<len; ++i) {
+    h ^= uchar(data[i]);
+    h *= 16777619u;
+  }
+  return h;
+}
+
+uint64
+hashBytes64(const char *data, int len, uint64 seed)
+{
+  const uint64 m = 0xc6a4a7935bd1e995ULL;
+  const int r = 47;
+  uint64 h = seed ^ (uint64(len) * m);
+  int i = 0;
+  for(; len - i >= 8; i += 8) {
+    uint64 k;
+    ::memcpy(&k, data + i, sizeof(k));
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+  }
+  if(i < len) {
+    for(int j = len - i - 1; j >= 0; --j)
+      h ^= uint64(uchar(data[i + j])) << (8 * j);
+    h *= m;
+  }
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
+
+int
+scanForAny(const char *text, int len, char a, char b, char c)
+{
+  int i = 0;
+#if defined(TT_HAVE_SSE2)
+  const __m128i va = _mm_set1_epi8(a);
+  const __m128i vb = _mm_set1_epi8(b);
+  const __m128i vc = _mm_set1_epi8(c);
+  for( ; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+    __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va),
+                                          _mm_cmpeq_epi8(v, vb)),
+                             _mm_cmpeq_epi8(v, vc));
+    if(int mask = _mm_movemask_epi8(m))
+      return i + countTrailingZeros(unsigned(mask));
+  }
+#endif
+  for( ; i < len; ++i) {
+    char x = text[i];
+    if(x == a || x == b || x == c)
+      return i;
+  }
+  return len;
+}
+
+int
+findBytes(const char *text, int len, const char *needle, int needleLen)
+{
+  if(needleLen <= 0)
+    return 0;
+  if(needleLen > len)
+    return -1;
+  if(needleLen == 1) {
+    const char *p = static_cast<const char *>(::memchr(text, needle[0], len));
+    return p ? int(p - text) : -1;
+  }
+  const int last = needleLen - 1;
+  // Index of the last position a match could start at
+  const int end = len - needleLen;
+  int i = 0;
+#if defined(TT_HAVE_SSE2)
+  // Test 16 positions at once for the needle's first and last bytes, and
+  // only compare the rest where both of those match.
+  const __m128i vfirst = _mm_set1_epi8(needle[0]);
+  const __m128i vlast = _mm_set1_epi8(needle[last]);
+  for( ; i + 16 <= end + 1; i += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+    __m128i b = _mm_loadu_si128(
+      reinterpret_cast<const __m128i *>(text + i + last));
+    unsigned mask = unsigned(_mm_movemask_epi8(
+      _mm_and_si128(_mm_cmpeq_epi8(a, vfirst), _mm_cmpeq_epi8(b, vlast))));
+    while(mask) {
+      int at = i + countTrailingZeros(mask);
+      if(!::memcmp(text + at + 1, needle + 1, needleLen - 2))
+        return at;
+      mask &= mask - 1;
+    }
+  }
+#endif
+  while(i <= end) {
+    const char *p = static_cast<const char *>(
+      ::memchr(text + i, needle[0], end - i + 1));
+    if(!p)
+      break;
+    i = int(p - text);
+    if(text[i + last] == needle[last]
+       && !::memcmp(text + i + 1, needle + 1, needleLen - 2))
+      return i;
+    ++i;
+  }
+  return -1;
+}
 
 } // TimedText
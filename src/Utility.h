@@ -28,13 +28,73 @@
 #ifndef __TimedText_UtilityPrivate__
 #define __TimedText_UtilityPrivate__
 
+#include <TimedText/Types.h>
 #include <climits>
 
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define TT_HAVE_SSE2
+#endif
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
 namespace TimedText
 {
 
 int allocMore(int alloc, int extra);
 
+// Let 'item' be moved from where rvalue references are supported, rather
+// than copied
+#if defined(TT_HAVE_RVALUE_REFS)
+template <typename T>
+inline T &&move(T &item)
+{
+  return static_cast<T &&>(item);
+}
+#else
+template <typename T>
+inline T &move(T &item)
+{
+  return item;
+}
+#endif
+
+// Index of the lowest set bit in a non-zero mask
+static inline int countTrailingZeros(unsigned mask)
+{
+#if defined(__GNUC__)
+  return __builtin_ctz(mask);
+#elif defined(_MSC_VER)
+  unsigned long i;
+  _BitScanForward(&i, mask);
+  return int(i);
+#else
+  int i = 0;
+  while(!(mask & 1))
+    mask >>= 1, ++i;
+  return i;
+#endif
+}
+
+// FNV-1a hash of 'len' bytes of 'data'
+uint32 hashBytes(const char *data, int len);
+
+// 64-bit hash of 'len' bytes of 'data', taking 8 bytes at a time (after
+// MurmurHash64A). Suited to hashing whole documents.
+uint64 hashBytes64(const char *data, int len, uint64 seed = 0);
+
+// Return the index of the first occurrence of 'a', 'b' or 'c' in the first
+// 'len' bytes of 'text', or 'len' if none of them occur. Scans 16 bytes at
+// a time where SSE2 is available.
+int scanForAny(const char *text, int len, char a, char b, char c);
+
+// Return the index of the first occurrence of the 'needleLen' bytes of
+// 'needle' in the first 'len' bytes of 'text', or -1 if there is none.
+// Embedded NUL bytes are matched like any other.
+int findBytes(const char *text, int len, const char *needle, int needleLen);
+
 } // TimedText
 
 #endif // __TimedText_UtilityPrivate__
@@ -26,10 +26,15 @@
 //
 
 #include <TimedText/WebVTTParser.h>
+#include <TimedText/CuetextCache.h>
 #include "WebVTTTokenizer.h"
+#include "Utility.h"
+
 namespace TimedText
 {
 
+static const Milliseconds MaxTimestamp = Milliseconds(~uint64(0) >> 1);
+
 WebVTTParser::WebVTTParser(Buffer &buf, Client *_client)
   : buffer(buf), client(_client)
 {
@@ -38,6 +43,10 @@ WebVTTParser::WebVTTParser(Buffer &buf, Client *_client)
   headerStatus = InitialHeader;
   withBOM = BOMUnknown;
   currentStartTime = currentEndTime = MalformedTimestamp;
+  nextOrder = 0;
+  windowSize = -1;
+  latestStart = lastEmitted = MalformedTimestamp;
+  numLateCues = 0;
 }
 
 WebVTTParser::~WebVTTParser()
@@ -288,11 +297,15 @@ WebVTTParser::dispatchCue()
   String text;
   // If this allocation fails, we have no way of notifying the user,
   // currently!
-  currentCueText.toString(text);
+  currentCueText.takeString(text, true);
   Cue cue(WebVTTCue, currentStartTime, currentEndTime,
           currentId, text);
   cue.applySettings(currentSettings);
-  currentCues.push(cue);
+  int emitted = currentCues.count();
+  if(windowSize < 0)
+    currentCues.push(move(cue));
+  else
+    holdCue(cue);
 
   // TODO:
   // Create Cue object and send it off to the client
@@ -302,10 +315,112 @@ WebVTTParser::dispatchCue()
   currentCueText.clear();
   state = Id;
 
-  if(client)
+  if(client && currentCues.count() > emitted)
+    client->cuesAvailable();
+}
+
+void
+WebVTTParser::setReorderWindow(Milliseconds window)
+{
+  windowSize = window < 0 ? -1 : window;
+  if(windowSize < 0 && releaseCues(MaxTimestamp) && client)
     client->cuesAvailable();
 }
 
+// A cue can be emitted once it starts 'windowSize' or more before the
+// latest start time seen, since any cue still to come should start no
+// earlier than that. Cues which do are late, and are passed on at once.
+void
+WebVTTParser::holdCue(const Cue &cue)
+{
+  Milliseconds start = cue.startTime();
+  if(lastEmitted != MalformedTimestamp && start < lastEmitted) {
+    ++numLateCues;
+    currentCues.push(cue);
+    if(client)
+      client->lateCue(cue);
+    return;
+  }
+  if(heldCues.isEmpty())
+    nextOrder = 0;
+  // If this allocation fails, the cue is passed on out of order rather than
+  // lost
+  int i = heldCues.count();
+  if(!heldCues.push(cue)) {
+    currentCues.push(cue);
+    return;
+  }
+  if(!heldStarts.push(start) || !heldOrder.push(nextOrder++)) {
+    if(heldStarts.count() > i)
+      heldStarts.pop();
+    heldCues.pop();
+    currentCues.push(cue);
+    return;
+  }
+  while(i > 0 && heldBefore(i, (i - 1) / 2)) {
+    swapHeld(i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+  if(start > latestStart)
+    latestStart = start;
+  if(latestStart - windowSize >= 0)
+    releaseCues(latestStart - windowSize);
+}
+
+// Emit held cues starting at or before 'until', in order. Returns true if
+// any were emitted.
+bool
+WebVTTParser::releaseCues(Milliseconds until)
+{
+  bool released = false;
+  while(!heldCues.isEmpty() && heldStarts[0] <= until) {
+    // If this allocation fails, the cue is held until the next release
+    // rather than lost
+    if(!currentCues.push(heldCues[0]))
+      break;
+    lastEmitted = heldStarts[0];
+    released = true;
+    int last = heldCues.count() - 1;
+    swapHeld(0, last);
+    heldCues.pop();
+    heldStarts.pop();
+    heldOrder.pop();
+    int i = 0;
+    for(;;) {
+      int child = 2 * i + 1;
+      if(child >= last)
+        break;
+      if(child + 1 < last && heldBefore(child + 1, child))
+        ++child;
+      if(!heldBefore(child, i))
+        break;
+      swapHeld(i, child);
+      i = child;
+    }
+  }
+  return released;
+}
+
+bool
+WebVTTParser::heldBefore(int a, int b)
+{
+  Milliseconds x = heldStarts[a];
+  Milliseconds y = heldStarts[b];
+  return x < y || (x == y && heldOrder[a] < heldOrder[b]);
+}
+
+void
+WebVTTParser::swapHeld(int a, int b)
+{
+  heldCues[a].swap(heldCues[b]);
+  Milliseconds start = heldStarts[a];
+  heldStarts[a] = heldStarts[b];
+  heldStarts[b] = start;
+  int order = heldOrder[a];
+  heldOrder[a] = heldOrder[b];
+  heldOrder[b] = order;
+}
+
 void
 WebVTTParser::dropCue()
 {
@@ -323,7 +438,7 @@ WebVTTParser::parse(Status *pstatus)
     return false;
   if(state == Initial)
     if(!parseHeader()) {
-      if(*pstatus)
+      if(pstatus)
         *pstatus = status;
       return false;
     }
@@ -391,6 +506,9 @@ retry:
   if(status != Aborted) {
     if(buffer.eof()) {
       status = Finished;
+      // Nothing can precede the cues still held
+      if(releaseCues(MaxTimestamp) && client)
+        client->cuesAvailable();
     } else {
       goto retry;
     }
@@ -407,9 +525,25 @@ WebVTTParser::parsedCues(List<Cue> &result)
   currentCues.clear();
 }
 
-// Translate CueText into tree of Node objects
-bool
-WebVTTParser::cuetextToNodes(const String &cuetext, Node &result)
+// Append current to its parent, and let current be the parent. Nodes are
+// only attached once they are complete, because a Node which is shared with
+// its parent's list of children would be copied when modified.
+static bool
+closeNode(List<Node> &nodeStack, Node &current)
+{
+  Node *parent;
+  if(!nodeStack.lastPtr(parent))
+    return false;
+  bool ret = parent->push(current);
+  current.swap(*parent);
+  nodeStack.pop();
+  return ret;
+}
+
+// Translate CueText into tree of Node objects, interning class names and
+// annotations in 'strings' if it is given
+static bool
+buildNodes(const String &cuetext, Node &result, StringPool *strings)
 {
   // 1. Let input be the string being parsed.
   // 2. Let position be a pointer into input, initially pointing at the start
@@ -423,10 +557,11 @@ WebVTTParser::cuetextToNodes(const String &cuetext, Node &result)
   if(input.isEmpty())
     return true;
   List<String> langStack;
+  // Open nodes which have not yet been appended to their parents
   List<Node> nodeStack;
-  Node current = result;
-  nodeStack.push(current);
-  WebVTTTokenizer tokenizer;
+  Node current;
+  current.swap(result);
+  WebVTTTokenizer tokenizer(strings);
   WebVTTToken token;
 
   // 6. Loop: if position is past the end of input, return result and abort
@@ -441,10 +576,10 @@ WebVTTParser::cuetextToNodes(const String &cuetext, Node &result)
       //      string token token.
       Node newTextNode(TextNode);
       String text;
-      token.data(text);
+      token.takeData(text);
       newTextNode.setText(text);
       //   2. Append the newly created WebVTT Text Object to current
-      current.push(newTextNode);
+      current.push(move(newTextNode));
     } else if(token.type() == WebVTTToken::StartTag) {
       // If token is a start tag
       String name;
@@ -499,10 +634,10 @@ WebVTTParser::cuetextToNodes(const String &cuetext, Node &result)
         String lang;
         if(langStack.lastItem(lang))
           newNode.setLang(lang);
-        // 4. Append the newly created node object to current.
-        current.push(newNode);
+        // 4. Append the newly created node object to current (once it has
+        //    been closed)
         nodeStack.push(current);
-        current = newNode;
+        current.swap(newNode);
       }
     } else if(token.type() == WebVTTToken::EndTag) {
       // If token is an end tag
@@ -519,7 +654,7 @@ WebVTTParser::cuetextToNodes(const String &cuetext, Node &result)
          || MatchingTag("ruby", RubyNode)
          || MatchingTag("rt", RubyTextNode)
          || MatchingTag("v", VoiceNode)) {
-        nodeStack.pop(current);
+        closeNode(nodeStack, current);
       } else if(MatchingTag("lang", LangNode)) {
         // Otherwise, if the tag name of the end tag token token is "lang",
         // and current is a WebVTT Language Object, then let current be the
@@ -527,13 +662,13 @@ WebVTTParser::cuetextToNodes(const String &cuetext, Node &result)
         // stack.
         String unused;
         langStack.pop(unused);
-        nodeStack.pop(current);
+        closeNode(nodeStack, current);
       } else if(MatchingTag("ruby", RubyTextNode)) {
         // Otherwise, if the tag name of the end tag token token is "ruby"
         // and current is a WebVTT Ruby Text Object, then let current be
         // the parent node of the parent node of current.
-        nodeStack.pop(current);
-        nodeStack.pop(current);
+        closeNode(nodeStack, current);
+        closeNode(nodeStack, current);
       }
       #undef MatchingTag
     } else if(token.type() == WebVTTToken::TimestampTag) {
@@ -552,7 +687,7 @@ WebVTTParser::cuetextToNodes(const String &cuetext, Node &result)
         // not valid, and so it can be safely ignored in that case.
         Node newNode(TimestampNode);
         newNode.setTimestamp(time);
-        current.push(newNode);
+        current.push(move(newNode));
       }
     }
 
@@ -560,9 +695,146 @@ WebVTTParser::cuetextToNodes(const String &cuetext, Node &result)
     token.reset();
   }
 
+  // Close any nodes left open at the end of the text
+  while(!nodeStack.isEmpty())
+    closeNode(nodeStack, current);
+  result.swap(current);
   return true;
 }
 
+bool
+WebVTTParser::cuetextToNodes(const String &cuetext, Node &result)
+{
+  return buildNodes(cuetext, result, 0);
+}
+
+bool
+WebVTTParser::cuetextToNodes(const String &cuetext, Node &result,
+                             StringPool &strings)
+{
+  return buildNodes(cuetext, result, &strings);
+}
+
+bool
+WebVTTParser::cuetextToNodes(const String &cuetext, Node &result,
+                             CuetextCache &cache)
+{
+  if(cache.find(cuetext, result))
+    return true;
+  if(!buildNodes(cuetext, result, &cache.strings()))
+    return false;
+  // Failing to cache the tree does not make it any less valid
+  cache.insert(cuetext, result);
+  return true;
+}
+
+// Let current be the parent of current, in terms of the element stack kept
+// by cuetextToPlainText()
+static bool
+popPlainTextElement(List<int> &elements, int &current, int &rubyTextDepth,
+                    StringBuilder &result, int flags)
+{
+  bool ret = true;
+  if(current == RubyTextNode) {
+    --rubyTextDepth;
+    if(flags & WebVTTParser::IncludeRubyText)
+      ret = result.append(')');
+  }
+  if(!elements.pop(current))
+    current = InternalTextNode;
+  return ret;
+}
+
+bool
+WebVTTParser::cuetextToPlainText(const String &cuetext, StringBuilder &result,
+                                 int flags)
+{
+  int position = 0;
+  if(cuetext.isEmpty())
+    return true;
+  // Rather than a stack of Nodes, only the element types of the open nodes
+  // are tracked, so that end tags are matched exactly as cuetextToNodes()
+  // would match them.
+  List<int> elements;
+  int current = InternalTextNode;
+  int rubyTextDepth = 0;
+  bool ok = true;
+  WebVTTTokenizer tokenizer;
+  WebVTTToken token;
+
+  while(ok && tokenizer.next(cuetext, position, token)) {
+    if(token.type() == WebVTTToken::EndOfFile)
+      break;
+    else if(token.type() == WebVTTToken::Text) {
+      // Ruby text is not part of the visible base text
+      if(!rubyTextDepth || (flags & IncludeRubyText))
+        ok = result.append(token.rawData());
+    } else if(token.type() == WebVTTToken::StartTag) {
+      const char *name = token.rawData().text();
+      int type = NullNode;
+      if(!::strcmp("c", name))
+        type = ClassNode;
+      else if(!::strcmp("i", name))
+        type = ItalicNode;
+      else if(!::strcmp("b", name))
+        type = BoldNode;
+      else if(!::strcmp("u", name))
+        type = UnderlineNode;
+      else if(!::strcmp("ruby", name))
+        type = RubyNode;
+      else if(!::strcmp("rt", name)) {
+        if(current == RubyNode)
+          type = RubyTextNode;
+      } else if(!::strcmp("v", name))
+        type = VoiceNode;
+      else if(!::strcmp("lang", name))
+        type = LangNode;
+
+      if(type == VoiceNode && (flags & IncludeVoicePrefix)
+         && (!rubyTextDepth || (flags & IncludeRubyText))) {
+        String voice = token.annotation();
+        if(!voice.isEmpty())
+          ok = result.append(voice) && result.append(": ");
+      } else if(type == RubyTextNode) {
+        ++rubyTextDepth;
+        if(flags & IncludeRubyText)
+          ok = result.append('(');
+      }
+      if(type != NullNode) {
+        ok = ok && elements.push(current);
+        current = type;
+      }
+    } else if(token.type() == WebVTTToken::EndTag) {
+      const char *name = token.rawData().text();
+      #define MatchingTag(tag,type) \
+      (!::strcmp(tag,name) && current == type)
+      if(MatchingTag("c", ClassNode)
+         || MatchingTag("i", ItalicNode)
+         || MatchingTag("b", BoldNode)
+         || MatchingTag("u", UnderlineNode)
+         || MatchingTag("ruby", RubyNode)
+         || MatchingTag("rt", RubyTextNode)
+         || MatchingTag("v", VoiceNode)
+         || MatchingTag("lang", LangNode)) {
+        ok = popPlainTextElement(elements, current, rubyTextDepth,
+                                 result, flags);
+      } else if(MatchingTag("ruby", RubyTextNode)) {
+        ok = popPlainTextElement(elements, current, rubyTextDepth,
+                                 result, flags)
+          && popPlainTextElement(elements, current, rubyTextDepth,
+                                 result, flags);
+      }
+      #undef MatchingTag
+    }
+    token.reset();
+  }
+
+  // Close any ruby annotations left open at the end of the text
+  while(ok && rubyTextDepth > 0)
+    ok = popPlainTextElement(elements, current, rubyTextDepth, result, flags);
+  return ok;
+}
+
 bool
 WebVTTParser::parseCuetext(Cue &cue)
 {
@@ -576,4 +848,17 @@ WebVTTParser::parseCuetext(Cue &cue)
   return false;
 }
 
+bool
+WebVTTParser::parseCuetext(Cue &cue, CuetextCache &cache)
+{
+  if(cue.type() != WebVTTCue)
+    return false;
+  Node nodes;
+  if(cuetextToNodes(cue.text(), nodes, cache)) {
+    cue.setNodes(nodes);
+    return true;
+  }
+  return false;
+}
+
 } // TimedText
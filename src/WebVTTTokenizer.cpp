@@ -26,7 +26,9 @@
 //
 
 #include <TimedText/Types.h>
+#include <TimedText/StringPool.h>
 #include "WebVTTTokenizer.h"
+#include "Utility.h"
 #include <assert.h>
 
 namespace TimedText
@@ -40,6 +42,15 @@ do { \
   c = nextChar(input, position); \
   goto state; \
 } while(0)
+// Entering the data state consumes any run of plain text first, so that
+// only the characters which end the run need to be decoded.
+#define ADVANCE_TO_DATA_STATE() \
+do { \
+  _state = WebVTTTokenizerState::DataState; \
+  bufferTextRun(input, position); \
+  c = nextChar(input, position); \
+  goto DataState; \
+} while(0)
 
 WebVTTToken::WebVTTToken()
  : _type(Uninitialized)
@@ -72,6 +83,12 @@ WebVTTToken::appendData(unsigned long ch)
   return _data.append(ch);
 }
 
+bool
+WebVTTToken::appendData(const char *text, int len)
+{
+  return _data.append(text, len);
+}
+
 bool
 WebVTTToken::appendData(const StringBuilder &buf)
 {
@@ -126,8 +143,9 @@ WebVTTToken::beginEndTag()
 static const uint32 endOfFileMark = uint32(-1);
 
 // Tokenizer
-WebVTTTokenizer::WebVTTTokenizer()
+WebVTTTokenizer::WebVTTTokenizer(StringPool *pool)
   : token(0),
+    strings(pool),
     _state(WebVTTTokenizerState::DataState)
 {
 }
@@ -169,6 +187,8 @@ WebVTTTokenizer::next(const String &input, int &position, WebVTTToken &result)
     return false;
   token = &result;
 
+  if(_state == WebVTTTokenizerState::DataState)
+    bufferTextRun(input, position);
   uint32 c = nextChar(input, position);
 
   switch(_state) {
@@ -188,7 +208,7 @@ WebVTTTokenizer::next(const String &input, int &position, WebVTTToken &result)
         return emitEndOfFile();
       else {
         bufferText(c);
-        ADVANCE_TO(DataState);
+        ADVANCE_TO_DATA_STATE();
       }
     END_STATE()
 
@@ -204,7 +224,7 @@ WebVTTTokenizer::next(const String &input, int &position, WebVTTToken &result)
           bufferText();
         }
         buffer.clear();
-        ADVANCE_TO(DataState);
+        ADVANCE_TO_DATA_STATE();
       } else if(c == '&') {
         // Append buffer to result, set buffer to c, and jump to the step
         // labeled next.
@@ -367,6 +387,24 @@ WebVTTTokenizer::bufferText()
   return ret;
 }
 
+bool
+WebVTTTokenizer::bufferTextRun(const String &input, int &position)
+{
+  // In the data state, only '<', '&' and CR are of any interest. The input
+  // is known to be valid UTF-8 and none of those bytes can occur inside of a
+  // multi-byte sequence, so everything up to the next one is appended
+  // verbatim, without decoding it.
+  if(position < 0 || position >= input.length())
+    return true;
+  const char *text = input.text() + position;
+  int n = scanForAny(text, input.length() - position, '<', '&', '\r');
+  if(!n)
+    return true;
+  position += n;
+  token->ensureIsText();
+  return token->appendData(text, n);
+}
+
 bool
 WebVTTTokenizer::haveBufferedTextToken()
 {
@@ -381,6 +419,16 @@ WebVTTTokenizer::appendName(uint c)
   return token->appendData(c);
 }
 
+// Let result be the contents of the buffer, interned if a StringPool is in
+// use
+bool
+WebVTTTokenizer::bufferToString(String &result) const
+{
+  if(strings)
+    return strings->intern(buffer.text(), buffer.length(), result);
+  return buffer.toString(result);
+}
+
 // Ensure that token is a StartTag, append the buffer to
 // its class list, and clear the buffer.
 bool
@@ -388,7 +436,7 @@ WebVTTTokenizer::appendClass()
 {
   assert(token->type() == WebVTTToken::StartTag);
   String result;
-  bool ret = buffer.toString(result) && token->appendClass(result);
+  bool ret = bufferToString(result) && token->appendClass(result);
   buffer.clear();
   return ret;
 }
@@ -404,7 +452,7 @@ WebVTTTokenizer::appendAnnotation()
       buffer.removeTrailingChar();
   }
   String result;
-  bool ret = buffer.toString(result) && token->setAnnotation(result);
+  bool ret = bufferToString(result) && token->setAnnotation(result);
   buffer.clear();
   return ret;
 }
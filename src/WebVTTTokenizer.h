@@ -36,6 +36,7 @@
 namespace TimedText
 {
 
+class StringPool;
 class WebVTTToken
 {
 public:
@@ -63,6 +64,14 @@ public:
   bool data(String &result) const {
     return _data.toString(result);
   }
+  // As data(), but leaves the token's data empty, saving a copy
+  bool takeData(String &result) {
+    return _data.takeString(result, true);
+  }
+  // Text, tag name or timestamp, without making a String of it
+  inline const StringBuilder &rawData() const {
+    return _data;
+  }
 
   Timestamp timestamp() const {
     String string;
@@ -85,6 +94,7 @@ public:
   }
 
   bool appendData(unsigned long ch);
+  bool appendData(const char *text, int len);
   bool appendData(const StringBuilder &buf);
   bool appendClass(const String &styleClass);
   inline bool setAnnotation(const String &annotation) {
@@ -129,7 +139,8 @@ class WebVTTTokenizer
 {
 public:
   typedef WebVTTTokenizerState::State State;
-  WebVTTTokenizer();
+  // If 'strings' is given, class names and annotations are interned in it
+  WebVTTTokenizer(StringPool *strings = 0);
   ~WebVTTTokenizer();
   uint32 nextChar(const String &input, int &position);
   void reset();
@@ -139,6 +150,7 @@ public:
   bool haveBufferedTextToken();
   bool bufferText(unsigned long ch);
   bool bufferText();
+  bool bufferTextRun(const String &input, int &position);
   bool appendName(uint c);
   bool appendClass();
   bool appendAnnotation();
@@ -148,7 +160,9 @@ public:
 private:
   bool emitAndResumeIn(State state);
   bool emitEndOfFile();
+  bool bufferToString(String &result) const;
   WebVTTToken *token;
+  StringPool *strings;
   State _state;
   StringBuilder buffer;
 };
@@ -39,6 +39,22 @@ TEST(Cue,Assignment)
   EXPECT_EQ(1000, cueB.endTime());
 }
 
+#if defined(TT_HAVE_RVALUE_REFS)
+TEST(Cue,Move)
+{
+  Cue cueA(WebVTTCue, 0.000, 1.000);
+  Cue cueB(static_cast<Cue &&>(cueA));
+  EXPECT_EQ(WebVTTCue, cueB.type());
+  EXPECT_EQ(1000, cueB.endTime());
+  EXPECT_EQ(EmptyCue, cueA.type());
+
+  Cue cueC(WebVTTCue, 2.000, 3.000);
+  cueC = static_cast<Cue &&>(cueB);
+  EXPECT_EQ(1000, cueC.endTime());
+  EXPECT_EQ(2000, cueB.startTime());
+}
+#endif
+
 TEST(Cue,SetId)
 {
   Cue cue(WebVTTCue, 0.000, 1.000);
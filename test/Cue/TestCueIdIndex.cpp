@@ -0,0 +1,114 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/CueIdIndex.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+using namespace TimedText;
+
+static Cue
+makeCue(double start, const char *id)
+{
+  return Cue(WebVTTCue, start, start + 1.0, id ? String(id) : String(),
+             String("text"));
+}
+
+TEST(CueIdIndex,Lookup)
+{
+  List<Cue> cues;
+  EXPECT_TRUE(cues.push(makeCue(1.0, "intro")));
+  EXPECT_TRUE(cues.push(makeCue(2.0, 0)));
+  EXPECT_TRUE(cues.push(makeCue(3.0, "")));
+  EXPECT_TRUE(cues.push(makeCue(4.0, "a long identifier, not stored inline")));
+  CueIdIndex index(cues);
+  EXPECT_EQ(4, index.count());
+  EXPECT_EQ(2, index.idCount());
+
+  EXPECT_EQ(0, index.indexOf(String("intro")));
+  EXPECT_EQ(3, index.indexOf(String("a long identifier, not stored inline")));
+  EXPECT_EQ(-1, index.indexOf(String("Intro")));
+  EXPECT_EQ(-1, index.indexOf(String("")));
+  EXPECT_EQ(-1, index.indexOf(String()));
+
+  Cue cue;
+  EXPECT_TRUE(index.find(String("intro"), cue));
+  EXPECT_EQ(cues.begin()[0], cue);
+  EXPECT_FALSE(index.find(String("outro"), cue));
+  EXPECT_EQ(cues.begin()[1], index.cueAt(1));
+
+  index.clear();
+  EXPECT_EQ(0, index.count());
+  EXPECT_EQ(-1, index.indexOf(String("intro")));
+}
+
+TEST(CueIdIndex,Duplicates)
+{
+  CueIdIndex index;
+  Cue a = makeCue(1.0, "chapter");
+  Cue b = makeCue(2.0, "other");
+  Cue c = makeCue(3.0, "chapter");
+  Cue d = makeCue(4.0, "chapter");
+  EXPECT_TRUE(index.insert(a));
+  EXPECT_TRUE(index.insert(b));
+  EXPECT_TRUE(index.insert(c));
+  EXPECT_TRUE(index.insert(d));
+  EXPECT_EQ(2, index.idCount());
+
+  // The first cue inserted wins, and the rest follow in order
+  Cue cue;
+  EXPECT_TRUE(index.find(String("chapter"), cue));
+  EXPECT_EQ(a, cue);
+  List<Cue> all;
+  EXPECT_TRUE(index.findAll(String("chapter"), all));
+  ASSERT_EQ(3, all.count());
+  EXPECT_EQ(a, all.begin()[0]);
+  EXPECT_EQ(c, all.begin()[1]);
+  EXPECT_EQ(d, all.begin()[2]);
+  all.clear();
+  EXPECT_TRUE(index.findAll(String("missing"), all));
+  EXPECT_EQ(0, all.count());
+}
+
+TEST(CueIdIndex,Many)
+{
+  CueIdIndex index;
+  char id[32];
+  for(int i = 0; i < 5000; ++i) {
+    ::sprintf(id, "cue-%d", i % 2500);
+    EXPECT_TRUE(index.insert(makeCue(i, id)));
+  }
+  EXPECT_EQ(5000, index.count());
+  EXPECT_EQ(2500, index.idCount());
+  for(int i = 0; i < 2500; i += 97) {
+    ::sprintf(id, "cue-%d", i);
+    EXPECT_EQ(i, index.indexOf(String(id)));
+    List<Cue> all;
+    EXPECT_TRUE(index.findAll(String(id), all));
+    ASSERT_EQ(2, all.count());
+    EXPECT_EQ(index.cueAt(i + 2500), all.begin()[1]);
+  }
+}
@@ -0,0 +1,188 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/CueScheduler.h>
+#include <gtest/gtest.h>
+using namespace TimedText;
+
+static String ids(const List<Cue> &cues)
+{
+  String result("");
+  Cue cue;
+  for(int i = 0; i < cues.count(); ++i) {
+    cues.itemAt(i, cue);
+    result += cue.id();
+  }
+  return result;
+}
+
+TEST(CueScheduler,Playback)
+{
+  CueScheduler scheduler;
+  EXPECT_TRUE(scheduler.insert(Cue(WebVTTCue, 0.000, 2.000, String("a"))));
+  EXPECT_TRUE(scheduler.insert(Cue(WebVTTCue, 1.000, 5.000, String("b"))));
+  EXPECT_TRUE(scheduler.insert(Cue(WebVTTCue, 3.500, 3.600, String("d"))));
+  EXPECT_TRUE(scheduler.insert(Cue(WebVTTCue, 2.000, 3.000, String("c"))));
+  EXPECT_FALSE(scheduler.insert(Cue(WebVTTCue, 2.000, 1.000)));
+  EXPECT_EQ(4, scheduler.count());
+  EXPECT_TRUE(scheduler.currentTime().isMalformed());
+
+  List<Cue> entered, exited, active;
+  EXPECT_TRUE(scheduler.update(0.000, entered, exited));
+  EXPECT_STREQ("a", ids(entered).text());
+  EXPECT_STREQ("", ids(exited).text());
+
+  entered.clear(); exited.clear();
+  EXPECT_TRUE(scheduler.update(1.500, entered, exited));
+  EXPECT_STREQ("b", ids(entered).text());
+  EXPECT_STREQ("", ids(exited).text());
+
+  entered.clear(); exited.clear();
+  EXPECT_TRUE(scheduler.update(2.500, entered, exited));
+  EXPECT_STREQ("c", ids(entered).text());
+  EXPECT_STREQ("a", ids(exited).text());
+  scheduler.activeCues(active);
+  EXPECT_STREQ("bc", ids(active).text());
+
+  // 'd' is missed, so it both enters and exits
+  entered.clear(); exited.clear();
+  EXPECT_TRUE(scheduler.update(4.000, entered, exited));
+  EXPECT_STREQ("d", ids(entered).text());
+  EXPECT_STREQ("cd", ids(exited).text());
+
+  entered.clear(); exited.clear();
+  EXPECT_TRUE(scheduler.update(6.000, entered, exited));
+  EXPECT_STREQ("", ids(entered).text());
+  EXPECT_STREQ("b", ids(exited).text());
+  scheduler.activeCues(active);
+  EXPECT_TRUE(active.isEmpty());
+  EXPECT_EQ(6000, scheduler.currentTime());
+}
+
+TEST(CueScheduler,Seek)
+{
+  CueScheduler scheduler;
+  EXPECT_TRUE(scheduler.insert(Cue(WebVTTCue, 0.000, 2.000, String("a"))));
+  EXPECT_TRUE(scheduler.insert(Cue(WebVTTCue, 1.000, 5.000, String("b"))));
+  EXPECT_TRUE(scheduler.insert(Cue(WebVTTCue, 2.000, 3.000, String("c"))));
+  EXPECT_TRUE(scheduler.insert(Cue(WebVTTCue, 3.500, 3.600, String("d"))));
+
+  // Skipped cues are not reported
+  List<Cue> entered, exited;
+  EXPECT_TRUE(scheduler.seek(4.000, entered, exited));
+  EXPECT_STREQ("b", ids(entered).text());
+  EXPECT_STREQ("", ids(exited).text());
+
+  // Moving backwards seeks
+  entered.clear(); exited.clear();
+  EXPECT_TRUE(scheduler.update(1.500, entered, exited));
+  EXPECT_STREQ("a", ids(entered).text());
+  EXPECT_STREQ("", ids(exited).text());
+
+  // Playback continues from the new position
+  entered.clear(); exited.clear();
+  EXPECT_TRUE(scheduler.update(2.500, entered, exited));
+  EXPECT_STREQ("c", ids(entered).text());
+  EXPECT_STREQ("a", ids(exited).text());
+
+  EXPECT_FALSE(scheduler.seek(Timestamp(), entered, exited));
+}
+
+TEST(CueScheduler,InsertWhileActive)
+{
+  CueScheduler scheduler;
+  EXPECT_TRUE(scheduler.insert(Cue(WebVTTCue, 1.000, 5.000, String("b"))));
+  List<Cue> entered, exited, active;
+  EXPECT_TRUE(scheduler.update(2.000, entered, exited));
+  EXPECT_STREQ("b", ids(entered).text());
+
+  EXPECT_TRUE(scheduler.insert(Cue(WebVTTCue, 0.000, 3.000, String("a"))));
+  EXPECT_TRUE(scheduler.insert(Cue(WebVTTCue, 0.000, 1.000, String("x"))));
+  scheduler.activeCues(active);
+  EXPECT_STREQ("ab", ids(active).text());
+
+  entered.clear(); exited.clear();
+  EXPECT_TRUE(scheduler.update(2.500, entered, exited));
+  EXPECT_STREQ("a", ids(entered).text());
+  EXPECT_STREQ("", ids(exited).text());
+
+  entered.clear(); exited.clear();
+  EXPECT_TRUE(scheduler.update(3.000, entered, exited));
+  EXPECT_STREQ("", ids(entered).text());
+  EXPECT_STREQ("a", ids(exited).text());
+}
+
+// Compare every update and seek against the cues' times
+TEST(CueScheduler,Consistency)
+{
+  List<Cue> cues;
+  uint32 seed = 4321;
+  for(int i = 0; i < 500; ++i) {
+    seed = seed * 1103515245 + 12345;
+    Milliseconds start = Milliseconds((seed >> 8) % 60000);
+    Milliseconds length = Milliseconds((seed >> 4) % 3000);
+    EXPECT_TRUE(cues.push(Cue(WebVTTCue, Timestamp(start),
+                              Timestamp(start + length))));
+  }
+  CueScheduler scheduler(cues);
+  EXPECT_EQ(500, scheduler.count());
+
+  Milliseconds last = MalformedTimestamp;
+  Milliseconds t = 0;
+  for(int step = 0; step < 400; ++step) {
+    seed = seed * 1103515245 + 12345;
+    bool seeking = (seed >> 16) % 10 == 0;
+    if(seeking)
+      t = Milliseconds((seed >> 4) % 65000);
+    else
+      t += Milliseconds((seed >> 8) % 400);
+
+    List<Cue> entered, exited;
+    if(seeking)
+      EXPECT_TRUE(scheduler.seek(Timestamp(t), entered, exited));
+    else
+      EXPECT_TRUE(scheduler.update(Timestamp(t), entered, exited));
+    bool forward = !seeking && t >= last;
+
+    List<Cue> active;
+    scheduler.activeCues(active);
+    Cue cue;
+    for(int i = 0; i < cues.count(); ++i) {
+      cues.itemAt(i, cue);
+      Milliseconds start = cue.startTime(), end = cue.endTime();
+      bool was = start <= last && end > last;
+      bool is = start <= t && end > t;
+      bool missed = forward && start > last && end <= t;
+      EXPECT_EQ(is, active.contains(cue));
+      EXPECT_EQ((!was && is) || missed, entered.contains(cue))
+        << start << "-" << end << " " << last << " to " << t;
+      EXPECT_EQ((was && !is) || missed, exited.contains(cue))
+        << start << "-" << end << " " << last << " to " << t;
+    }
+    last = t;
+  }
+}
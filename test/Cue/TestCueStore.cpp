@@ -0,0 +1,132 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/CueStore.h>
+#include <gtest/gtest.h>
+using namespace TimedText;
+
+TEST(CueStore,RoundTrip)
+{
+  CueStore store;
+  Cue a(WebVTTCue, 1.000, 2.500, String("intro"), String("Hello <b>world</b>"));
+  a.applySettings(String("line:10% position:20% size:30% align:start "
+                         "vertical:rl"));
+  Cue b(WebVTTCue, 3.000, 4.000, String(), String(""));
+  EXPECT_TRUE(store.append(a));
+  EXPECT_TRUE(store.append(b));
+  EXPECT_EQ(2, store.count());
+  EXPECT_EQ(1000, store.startTimes()[0]);
+  EXPECT_EQ(4000, store.endTimes()[1]);
+  EXPECT_EQ(23, store.textSize());
+
+  Cue cue;
+  EXPECT_TRUE(store.cueAt(0, cue));
+  EXPECT_NE(a, cue);
+  EXPECT_EQ(WebVTTCue, cue.type());
+  EXPECT_EQ(1000, cue.startTime());
+  EXPECT_EQ(2500, cue.endTime());
+  EXPECT_STREQ("intro", cue.id().text());
+  EXPECT_STREQ("Hello <b>world</b>", cue.text().text());
+  EXPECT_EQ(a.line(), cue.line());
+  EXPECT_EQ(a.snapToLines(), cue.snapToLines());
+  EXPECT_EQ(20, cue.position());
+  EXPECT_EQ(30, cue.size());
+  EXPECT_EQ(Cue::Start, cue.align());
+  EXPECT_EQ(Cue::VerticalRightToLeft, cue.vertical());
+
+  EXPECT_TRUE(store.cueAt(1, cue));
+  EXPECT_TRUE(cue.id().isNull());
+  EXPECT_FALSE(cue.text().isNull());
+  EXPECT_TRUE(cue.text().isEmpty());
+  EXPECT_EQ(b.line(), cue.line());
+  EXPECT_EQ(b.snapToLines(), cue.snapToLines());
+  EXPECT_EQ(b.position(), cue.position());
+  EXPECT_EQ(b.size(), cue.size());
+  EXPECT_EQ(b.align(), cue.align());
+  EXPECT_EQ(b.vertical(), cue.vertical());
+
+  EXPECT_FALSE(store.cueAt(2, cue));
+  store.clear();
+  EXPECT_EQ(0, store.count());
+  EXPECT_EQ(0, store.textSize());
+}
+
+TEST(CueStore,EmptyText)
+{
+  // Cues without any text leave the text buffer unallocated
+  CueStore store;
+  Cue a(WebVTTCue, 1.000, 2.000, String(""), String(""));
+  EXPECT_TRUE(store.append(a));
+  EXPECT_EQ(0, store.textSize());
+  Cue cue;
+  EXPECT_TRUE(store.cueAt(0, cue));
+  EXPECT_FALSE(cue.id().isNull());
+  EXPECT_TRUE(cue.id().isEmpty());
+  EXPECT_FALSE(cue.text().isNull());
+  EXPECT_TRUE(cue.text().isEmpty());
+}
+
+TEST(CueStore,ActiveCues)
+{
+  List<Cue> cues;
+  uint32 seed = 999;
+  for(int i = 0; i < 1000; ++i) {
+    seed = seed * 1103515245 + 12345;
+    Milliseconds start = Milliseconds((seed >> 8) % 100000);
+    Milliseconds length = Milliseconds((seed >> 4) % 5000);
+    char text[32];
+    snprintf(text, sizeof(text), "Cue number %d", i);
+    EXPECT_TRUE(cues.push(Cue(WebVTTCue, Timestamp(start),
+                              Timestamp(start + length), String(), 
+                              String(text))));
+  }
+  CueStore store;
+  EXPECT_TRUE(store.append(cues));
+  EXPECT_EQ(1000, store.count());
+
+  Cue cue;
+  for(int i = 0; i < cues.count(); ++i) {
+    EXPECT_TRUE(cues.itemAt(i, cue));
+    EXPECT_STREQ(cue.text().text(), store.text(i).text());
+    EXPECT_EQ(Milliseconds(cue.startTime()), store.startTime(i));
+  }
+
+  for(Milliseconds t = 0; t < 110000; t += 1009) {
+    List<int> result;
+    EXPECT_TRUE(store.activeCues(Timestamp(t), result));
+    int expected = 0;
+    for(int i = 0; i < cues.count(); ++i) {
+      EXPECT_TRUE(cues.itemAt(i, cue));
+      if(cue.startTime() <= t && cue.endTime() > t) {
+        int index = -1;
+        EXPECT_TRUE(result.itemAt(expected++, index));
+        EXPECT_EQ(i, index);
+      }
+    }
+    EXPECT_EQ(expected, result.count());
+  }
+}
@@ -0,0 +1,200 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/CueTextIndex.h>
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <cstring>
+using namespace TimedText;
+
+static Cue
+makeCue(double start, double end, const char *text)
+{
+  return Cue(WebVTTCue, start, end, String(), String(text));
+}
+
+static void
+addCues(CueTextIndex &index)
+{
+  EXPECT_TRUE(index.add(makeCue(1.000, 2.000,
+                                "<v Anne>The <b>quick</b> brown fox</v>")));
+  EXPECT_TRUE(index.add(makeCue(2.000, 3.000, "jumps over the lazy dog")));
+  EXPECT_TRUE(index.add(makeCue(3.000, 4.500,
+                                "Quick! Quickly, &amp; QUICKER.")));
+  EXPECT_TRUE(index.add(makeCue(5.000, 6.000,
+                                "Un CAF\xc3\x89 \xce\xa3\xce\x9f\xce\xa6"
+                                "\xce\x9f\xce\xa3, caf\xc3\xa9")));
+}
+
+static void
+expectCues(const List<int> &result, int count, const int *expected)
+{
+  EXPECT_EQ(count, result.count());
+  for(int i = 0; i < count && i < result.count(); ++i)
+    EXPECT_EQ(expected[i], result.begin()[i]);
+}
+
+static void
+expectQueries(const CueTextIndex &index)
+{
+  List<int> result;
+  EXPECT_TRUE(index.find(String("QUICK"), result));
+  const int quick[] = { 0, 2 };
+  expectCues(result, 2, quick);
+
+  // Tags and voices are not words
+  result.clear();
+  EXPECT_TRUE(index.find(String("anne"), result));
+  EXPECT_TRUE(index.find(String("b"), result));
+  EXPECT_TRUE(index.find(String("amp"), result));
+  EXPECT_TRUE(index.find(String("qui"), result));
+  EXPECT_EQ(0, result.count());
+
+  EXPECT_TRUE(index.findPrefix(String("qui"), result));
+  expectCues(result, 2, quick);
+
+  result.clear();
+  EXPECT_TRUE(index.findPrefix(String("THE"), result));
+  const int the[] = { 0, 1 };
+  expectCues(result, 2, the);
+
+  // Case is folded outside of ASCII, and words may end the text
+  result.clear();
+  EXPECT_TRUE(index.find(String("caf\xc3\xa9"), result));
+  EXPECT_TRUE(index.find(String("\xcf\x83\xce\xbf\xcf\x86\xce\xbf\xcf\x82"),
+                         result));
+  const int cafe[] = { 3, 3 };
+  expectCues(result, 2, cafe);
+
+  // Phrases match across tags, but not out of order or between cues
+  result.clear();
+  EXPECT_TRUE(index.findPhrase(String("the quick, brown"), result));
+  EXPECT_TRUE(index.findPhrase(String("brown quick"), result));
+  EXPECT_TRUE(index.findPhrase(String("fox jumps"), result));
+  const int phrase[] = { 0 };
+  expectCues(result, 1, phrase);
+  result.clear();
+  EXPECT_TRUE(index.findPhrase(String("the lazy dog"), result));
+  EXPECT_TRUE(index.findPhrase(String("lazy"), result));
+  EXPECT_TRUE(index.findPhrase(String(""), result));
+  const int lazy[] = { 1, 1 };
+  expectCues(result, 2, lazy);
+
+  EXPECT_EQ(3000, index.startTime(2));
+  EXPECT_EQ(4500, index.endTime(2));
+}
+
+TEST(CueTextIndex,Queries)
+{
+  CueTextIndex index;
+  addCues(index);
+  EXPECT_EQ(4, index.count());
+  EXPECT_EQ(13, index.wordCount());
+  expectQueries(index);
+}
+
+TEST(CueTextIndex,Incremental)
+{
+  CueTextIndex index;
+  List<int> result;
+  EXPECT_TRUE(index.add(makeCue(1.000, 2.000, "zebra apple")));
+  EXPECT_TRUE(index.findPrefix(String("a"), result));
+  EXPECT_EQ(1, result.count());
+
+  // New words are merged into the sorted ones by the next query
+  EXPECT_TRUE(index.add(makeCue(2.000, 3.000, "banana avocado zucchini")));
+  EXPECT_TRUE(index.add(makeCue(3.000, 4.000, "apricot")));
+  result.clear();
+  EXPECT_TRUE(index.findPrefix(String("a"), result));
+  const int a[] = { 0, 1, 2 };
+  expectCues(result, 3, a);
+  result.clear();
+  EXPECT_TRUE(index.findPrefix(String("z"), result));
+  const int z[] = { 0, 1 };
+  expectCues(result, 2, z);
+
+  // Many cues and words, to grow every table
+  char text[64];
+  for(int i = 0; i < 2000; ++i) {
+    ::sprintf(text, "word%d common", i);
+    EXPECT_TRUE(index.add(makeCue(10.0 + i, 11.0 + i, text)));
+  }
+  result.clear();
+  EXPECT_TRUE(index.find(String("word1234"), result));
+  ASSERT_EQ(1, result.count());
+  EXPECT_EQ(1237, result[0]);
+  result.clear();
+  EXPECT_TRUE(index.findPrefix(String("word12"), result));
+  EXPECT_EQ(111, result.count());
+  result.clear();
+  EXPECT_TRUE(index.findPhrase(String("word1999 common"), result));
+  EXPECT_EQ(1, result.count());
+}
+
+TEST(CueTextIndex,Image)
+{
+  CueTextIndex index;
+  addCues(index);
+  int size = index.imageSize();
+  EXPECT_GT(size, 0);
+  // Allocated as uint64 for its alignment
+  uint64 *image = new uint64[size / 8 + 1];
+  EXPECT_FALSE(index.writeImage(image, size - 1));
+  EXPECT_TRUE(index.writeImage(image, size));
+
+  CueTextIndex opened;
+  EXPECT_TRUE(opened.open(image, size));
+  EXPECT_TRUE(opened.isOpen());
+  EXPECT_EQ(4, opened.count());
+  EXPECT_EQ(13, opened.wordCount());
+  EXPECT_FALSE(opened.add(makeCue(7.000, 8.000, "more")));
+  expectQueries(opened);
+
+  // An opened index writes the same image again
+  uint64 *copy = new uint64[size / 8 + 1];
+  EXPECT_EQ(size, opened.imageSize());
+  EXPECT_TRUE(opened.writeImage(copy, size));
+  EXPECT_EQ(0, ::memcmp(image, copy, size));
+
+  // Damaged images are rejected
+  EXPECT_FALSE(opened.open(image, size - 1));
+  EXPECT_FALSE(opened.open(reinterpret_cast<char *>(image) + 4, size - 4));
+  char *bytes = reinterpret_cast<char *>(copy);
+  bytes[0] = 'X';
+  EXPECT_FALSE(opened.open(copy, size));
+  EXPECT_TRUE(index.writeImage(copy, size));
+  // The first posting (of "brown") follows the header, start and end
+  // times, and the 13 term records; make it refer to a fifth cue
+  int32 *posting = reinterpret_cast<int32 *>(bytes + 56 + 4 * 16 + 13 * 16);
+  EXPECT_EQ(0, *posting);
+  *posting = 4;
+  EXPECT_FALSE(opened.open(copy, size));
+  EXPECT_FALSE(opened.isOpen());
+
+  delete [] image;
+  delete [] copy;
+}
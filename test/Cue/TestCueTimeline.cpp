@@ -0,0 +1,173 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/CueTimeline.h>
+#include <gtest/gtest.h>
+using namespace TimedText;
+
+// Deterministic cues of varying length, some of them overlapping
+static void makeCues(List<Cue> &cues, int count, bool sorted)
+{
+  uint32 seed = 12345;
+  Milliseconds start = 0;
+  for(int i = 0; i < count; ++i) {
+    seed = seed * 1103515245 + 12345;
+    Milliseconds from = sorted ? start : Milliseconds((seed >> 8) % 100000);
+    Milliseconds length = Milliseconds((seed >> 4) % 5000);
+    EXPECT_TRUE(cues.push(Cue(WebVTTCue, Timestamp(from),
+                              Timestamp(from + length))));
+    start += Milliseconds((seed >> 12) % 700);
+  }
+}
+
+static void expectSameCues(const List<Cue> &cues, Milliseconds from,
+                           Milliseconds to, const List<Cue> &result)
+{
+  int expected = 0;
+  Cue cue, found;
+  for(int i = 0; i < cues.count(); ++i) {
+    EXPECT_TRUE(cues.itemAt(i, cue));
+    if(cue.startTime() < to && cue.endTime() > from)
+      ++expected;
+  }
+  EXPECT_EQ(expected, result.count()) << "[" << from << ", " << to << ")";
+  Milliseconds last = 0;
+  for(int i = 0; i < result.count(); ++i) {
+    EXPECT_TRUE(result.itemAt(i, found));
+    EXPECT_LT(Milliseconds(found.startTime()), to);
+    EXPECT_GT(Milliseconds(found.endTime()), from);
+    EXPECT_LE(last, Milliseconds(found.startTime()));
+    last = found.startTime();
+  }
+}
+
+TEST(CueTimeline,ActiveCues)
+{
+  CueTimeline timeline;
+  EXPECT_TRUE(timeline.insert(Cue(WebVTTCue, 0.000, 2.000, String("a"))));
+  EXPECT_TRUE(timeline.insert(Cue(WebVTTCue, 1.000, 5.000, String("b"))));
+  EXPECT_TRUE(timeline.insert(Cue(WebVTTCue, 2.000, 3.000, String("c"))));
+  EXPECT_TRUE(timeline.insert(Cue(WebVTTCue, 4.000, 4.000, String("d"))));
+  EXPECT_EQ(4, timeline.count());
+
+  List<Cue> result;
+  Cue cue;
+  EXPECT_TRUE(timeline.activeCues(1.500, result));
+  EXPECT_EQ(2, result.count());
+  EXPECT_TRUE(result.itemAt(0, cue));
+  EXPECT_STREQ("a", cue.id().text());
+  EXPECT_TRUE(result.itemAt(1, cue));
+  EXPECT_STREQ("b", cue.id().text());
+
+  // A cue is no longer active at its end time
+  result.clear();
+  EXPECT_TRUE(timeline.activeCues(2.000, result));
+  EXPECT_EQ(2, result.count());
+  EXPECT_TRUE(result.itemAt(0, cue));
+  EXPECT_STREQ("b", cue.id().text());
+  EXPECT_TRUE(result.itemAt(1, cue));
+  EXPECT_STREQ("c", cue.id().text());
+
+  // Cues of no length are never active
+  result.clear();
+  EXPECT_TRUE(timeline.activeCues(4.000, result));
+  EXPECT_EQ(1, result.count());
+
+  result.clear();
+  EXPECT_TRUE(timeline.activeCues(5.000, result));
+  EXPECT_TRUE(result.isEmpty());
+
+  result.clear();
+  EXPECT_TRUE(timeline.cuesBetween(2.500, 4.500, result));
+  EXPECT_EQ(3, result.count());
+}
+
+TEST(CueTimeline,Malformed)
+{
+  CueTimeline timeline;
+  EXPECT_FALSE(timeline.insert(Cue(WebVTTCue, Timestamp(), 1.000)));
+  EXPECT_FALSE(timeline.insert(Cue(WebVTTCue, 1.000, Timestamp())));
+  EXPECT_EQ(0, timeline.count());
+  List<Cue> result;
+  EXPECT_TRUE(timeline.activeCues(1.000, result));
+  EXPECT_FALSE(timeline.activeCues(Timestamp(), result));
+  EXPECT_TRUE(result.isEmpty());
+}
+
+TEST(CueTimeline,InOrder)
+{
+  List<Cue> cues;
+  makeCues(cues, 1000, true);
+  CueTimeline timeline;
+  // Inserted one at a time, as they would be while parsing
+  Cue cue;
+  for(int i = 0; i < cues.count(); ++i) {
+    EXPECT_TRUE(cues.itemAt(i, cue));
+    EXPECT_TRUE(timeline.insert(cue));
+  }
+  EXPECT_EQ(1000, timeline.count());
+  for(Milliseconds t = 0; t < 400000; t += 997) {
+    List<Cue> result;
+    EXPECT_TRUE(timeline.activeCues(Timestamp(t), result));
+    expectSameCues(cues, t, t + 1, result);
+  }
+}
+
+TEST(CueTimeline,OutOfOrder)
+{
+  List<Cue> cues;
+  makeCues(cues, 1000, false);
+  CueTimeline timeline(cues);
+  EXPECT_EQ(1000, timeline.count());
+  for(Milliseconds t = 0; t < 110000; t += 331) {
+    List<Cue> result;
+    EXPECT_TRUE(timeline.activeCues(Timestamp(t), result));
+    expectSameCues(cues, t, t + 1, result);
+    result.clear();
+    EXPECT_TRUE(timeline.cuesBetween(Timestamp(t), Timestamp(t + 2000),
+                                     result));
+    expectSameCues(cues, t, t + 2000, result);
+  }
+
+  // Mixing later cues into an existing timeline
+  List<Cue> more;
+  makeCues(more, 100, true);
+  Cue cue;
+  for(int i = 0; i < more.count(); ++i) {
+    EXPECT_TRUE(more.itemAt(i, cue));
+    EXPECT_TRUE(timeline.insert(cue));
+    EXPECT_TRUE(cues.push(cue));
+  }
+  for(Milliseconds t = 0; t < 110000; t += 331) {
+    List<Cue> result;
+    EXPECT_TRUE(timeline.activeCues(Timestamp(t), result));
+    expectSameCues(cues, t, t + 1, result);
+  }
+
+  timeline.clear();
+  EXPECT_EQ(0, timeline.count());
+}
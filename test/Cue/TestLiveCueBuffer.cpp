@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/LiveCueBuffer.h>
+#include <gtest/gtest.h>
+using namespace TimedText;
+
+static Cue
+makeCue(Milliseconds start, Milliseconds end)
+{
+  return Cue(WebVTTCue, Timestamp(start), Timestamp(end), String(),
+             String("text"));
+}
+
+TEST(LiveCueBuffer,Retention)
+{
+  LiveCueBuffer buffer(10000);
+  EXPECT_EQ(10000, buffer.retention());
+  EXPECT_TRUE(buffer.liveEdge().isMalformed());
+  EXPECT_FALSE(buffer.append(Cue(WebVTTCue, Timestamp(), 1.000)));
+
+  Cue a = makeCue(0, 5000);
+  Cue b = makeCue(2000, 20000);
+  Cue c = makeCue(4000, 8000);
+  EXPECT_TRUE(buffer.append(a));
+  EXPECT_TRUE(buffer.append(b));
+  EXPECT_TRUE(buffer.append(c));
+  EXPECT_EQ(4000, buffer.liveEdge());
+  // Kept in order of end time
+  ASSERT_EQ(3, buffer.count());
+  EXPECT_EQ(a, buffer.cueAt(0));
+  EXPECT_EQ(c, buffer.cueAt(1));
+  EXPECT_EQ(b, buffer.cueAt(2));
+
+  // Cues ending more than 10 seconds before the edge are evicted
+  buffer.setLiveEdge(Timestamp(Milliseconds(15001)));
+  ASSERT_EQ(2, buffer.count());
+  EXPECT_EQ(c, buffer.cueAt(0));
+  EXPECT_EQ(1, buffer.evictedCount());
+  buffer.setLiveEdge(Timestamp(Milliseconds(1000)));
+  EXPECT_EQ(15001, buffer.liveEdge());
+
+  // A cue starting later moves the edge too
+  EXPECT_TRUE(buffer.append(makeCue(30000, 31000)));
+  ASSERT_EQ(2, buffer.count());
+  EXPECT_EQ(b, buffer.cueAt(0));
+
+  // Cues which have already expired are not kept
+  EXPECT_TRUE(buffer.append(makeCue(1000, 2000)));
+  EXPECT_EQ(2, buffer.count());
+  EXPECT_EQ(3, buffer.evictedCount());
+
+  buffer.setRetention(5000);
+  EXPECT_EQ(1, buffer.count());
+  List<Cue> cues;
+  buffer.liveCues(cues);
+  EXPECT_EQ(1, cues.count());
+  buffer.clear();
+  EXPECT_EQ(0, buffer.count());
+  EXPECT_TRUE(buffer.liveEdge().isMalformed());
+}
+
+TEST(LiveCueBuffer,ReleasesCues)
+{
+  LiveCueBuffer buffer(1000);
+  Cue cue = makeCue(0, 500);
+  EXPECT_TRUE(buffer.append(cue));
+  List<Cue> shared;
+  buffer.liveCues(shared);
+  // Evicting from a list shared with a client copies it first
+  buffer.setLiveEdge(Timestamp(Milliseconds(2000)));
+  EXPECT_EQ(0, buffer.count());
+  EXPECT_EQ(1, shared.count());
+  EXPECT_EQ(cue, shared.begin()[0]);
+}
+
+TEST(LiveCueBuffer,Plateau)
+{
+  // A long stream of cues, each lasting two seconds, keeps about as many
+  // cues as fit in the retention period
+  LiveCueBuffer buffer(10000);
+  List<Cue> batch;
+  for(Milliseconds t = 0; t < 2000000; t += 1000) {
+    EXPECT_TRUE(batch.push(makeCue(t, t + 2000)));
+    if(batch.count() == 10) {
+      EXPECT_TRUE(buffer.append(batch));
+      batch.clear();
+    }
+    EXPECT_LE(buffer.count(), 13);
+  }
+  EXPECT_EQ(13, buffer.count());
+  EXPECT_EQ(2000 - buffer.count(), buffer.evictedCount());
+  for(int i = 1; i < buffer.count(); ++i)
+    EXPECT_LE(buffer.cueAt(i - 1).endTime(), buffer.cueAt(i).endTime());
+}
@@ -0,0 +1,217 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/TimeTransform.h>
+#include <TimedText/CueStore.h>
+#include <TimedText/WebVTTParser.h>
+#include <gtest/gtest.h>
+#include <cstdlib>
+using namespace TimedText;
+
+TEST(TimeTransform,Identity)
+{
+  TimeTransform t;
+  EXPECT_TRUE(t.isIdentity());
+  Milliseconds times[] = { 0, 1, 1234567, -1 };
+  t.apply(times, 4);
+  EXPECT_EQ(0, times[0]);
+  EXPECT_EQ(1, times[1]);
+  EXPECT_EQ(1234567, times[2]);
+  EXPECT_EQ(-1, times[3]);
+}
+
+TEST(TimeTransform,ShiftAndClamp)
+{
+  TimeTransform t;
+  t.setOffset(-1500);
+  Milliseconds times[] = { 0, 1000, 2000, -1 };
+  t.apply(times, 4);
+  EXPECT_EQ(0, times[0]);
+  EXPECT_EQ(0, times[1]);
+  EXPECT_EQ(500, times[2]);
+  EXPECT_EQ(-1, times[3]);
+
+  t.setOffset(250);
+  t.setWindow(1000, 2000);
+  Milliseconds more[] = { 0, 1000, 1500, 1900, 3000 };
+  t.apply(more, 5);
+  EXPECT_EQ(1000, more[0]);
+  EXPECT_EQ(1250, more[1]);
+  EXPECT_EQ(1750, more[2]);
+  EXPECT_EQ(2000, more[3]);
+  EXPECT_EQ(2000, more[4]);
+  EXPECT_TRUE(t.apply(Timestamp()).isMalformed());
+}
+
+TEST(TimeTransform,ScaleRounding)
+{
+  TimeTransform t;
+  EXPECT_FALSE(t.setScale(0, 1));
+  EXPECT_FALSE(t.setScale(1, -1));
+  EXPECT_TRUE(t.setScale(3, 2));
+  // Halves are rounded up
+  Milliseconds times[] = { 1, 2, 3, -1 };
+  t.apply(times, 4);
+  EXPECT_EQ(2, times[0]);
+  EXPECT_EQ(3, times[1]);
+  EXPECT_EQ(5, times[2]);
+  EXPECT_EQ(-1, times[3]);
+
+  // 25fps to 23.976fps, then a shift
+  EXPECT_TRUE(t.setScale(25025, 24000));
+  t.setOffset(-40);
+  Milliseconds ms = 1000;
+  t.apply(&ms, 1);
+  EXPECT_EQ(1003, ms);
+
+  // Huge times saturate rather than overflow
+  EXPECT_TRUE(t.setScale(1000000, 1));
+  t.setOffset(0);
+  ms = Milliseconds(1) << 60;
+  t.apply(&ms, 1);
+  EXPECT_EQ(TimeTransform::maxTime(), ms);
+}
+
+TEST(TimeTransform,MatchesReference)
+{
+  srand(7);
+  enum { N = 1000 };
+  Milliseconds times[N];
+  Milliseconds expected[N];
+  TimeTransform t;
+  for(int round = 0; round < 20; ++round) {
+    int num = 1 + rand() % 100000;
+    int den = 1 + rand() % 100000;
+    Milliseconds offset = Milliseconds(rand() % 2000000) - 1000000;
+    Milliseconds first = rand() % 100000;
+    Milliseconds last = first + Milliseconds(rand()) * 100;
+    EXPECT_TRUE(t.setScale(num, den));
+    t.setOffset(offset);
+    t.setWindow(first, last);
+    for(int i = 0; i < N; ++i) {
+      times[i] = (i % 17) == 0 ? -1 : Milliseconds(rand()) * 7;
+      if(times[i] < 0) {
+        expected[i] = times[i];
+        continue;
+      }
+      // Small enough that the product fits in 64 bits
+      uint64 p = uint64(times[i]) * num;
+      Milliseconds v = Milliseconds((p + den / 2) / den) + offset;
+      expected[i] = v < first ? first : v > last ? last : v;
+    }
+    t.apply(times, N);
+    for(int i = 0; i < N; ++i)
+      EXPECT_EQ(expected[i], times[i]);
+  }
+}
+
+TEST(TimeTransform,Cues)
+{
+  Cue a(WebVTTCue, 1.000, 4.000, String(),
+        String("One <00:00:02.000>Two <b><00:00:03.000>Three</b>"));
+  Cue b(WebVTTCue, 5.000, 6.000, String(), String("Plain"));
+  EXPECT_TRUE(WebVTTParser::parseCuetext(a));
+  EXPECT_TRUE(WebVTTParser::parseCuetext(b));
+  Node before;
+  EXPECT_TRUE(a.nodes(before));
+  Node plain;
+  EXPECT_TRUE(b.nodes(plain));
+
+  List<Cue> cues;
+  EXPECT_TRUE(cues.push(a));
+  EXPECT_TRUE(cues.push(b));
+  TimeTransform t;
+  t.setOffset(500);
+  EXPECT_TRUE(t.apply(cues));
+  EXPECT_EQ(1500, a.startTime());
+  EXPECT_EQ(4500, a.endTime());
+  EXPECT_EQ(5500, b.startTime());
+  EXPECT_EQ(6500, b.endTime());
+
+  // Timestamps in the new tree are moved, while the old tree (which was
+  // shared with the cue) is left alone.
+  Node after;
+  EXPECT_TRUE(a.nodes(after));
+  EXPECT_NE(before, after);
+  Node child;
+  EXPECT_TRUE(after.itemAt(1, child));
+  EXPECT_EQ(TimestampNode, child.element());
+  EXPECT_EQ(2500, child.timestamp());
+  Node bold;
+  EXPECT_TRUE(after.itemAt(3, bold));
+  EXPECT_TRUE(bold.itemAt(0, child));
+  EXPECT_EQ(3500, child.timestamp());
+  EXPECT_TRUE(before.itemAt(1, child));
+  EXPECT_EQ(2000, child.timestamp());
+
+  // Trees without timestamps are not copied
+  Node same;
+  EXPECT_TRUE(b.nodes(same));
+  EXPECT_EQ(plain, same);
+}
+
+TEST(TimeTransform,SharedBranches)
+{
+  Node tree;
+  EXPECT_TRUE(WebVTTParser::cuetextToNodes(
+    String("<b>plain <i>x</i></b><00:00:01.000>y"), tree));
+  Node shared = tree;
+  Node bold;
+  EXPECT_TRUE(tree.itemAt(0, bold));
+  EXPECT_EQ(BoldNode, bold.element());
+
+  TimeTransform t;
+  t.setOffset(500);
+  EXPECT_TRUE(t.apply(tree));
+  EXPECT_NE(shared, tree);
+  Node child;
+  EXPECT_TRUE(tree.itemAt(1, child));
+  EXPECT_EQ(1500, child.timestamp());
+  EXPECT_TRUE(shared.itemAt(1, child));
+  EXPECT_EQ(1000, child.timestamp());
+
+  // The branch without timestamps is still shared by both trees
+  EXPECT_TRUE(tree.itemAt(0, child));
+  EXPECT_EQ(bold, child);
+}
+
+TEST(TimeTransform,CueStore)
+{
+  CueStore store;
+  EXPECT_TRUE(store.append(Cue(WebVTTCue, 1.000, 2.000, String(),
+                               String("a"))));
+  EXPECT_TRUE(store.append(Cue(WebVTTCue, 2.000, 3.000, String(),
+                               String("b"))));
+  TimeTransform t;
+  EXPECT_TRUE(t.setScale(2, 1));
+  t.setOffset(-1000);
+  store.transform(t);
+  EXPECT_EQ(1000, store.startTimes()[0]);
+  EXPECT_EQ(3000, store.endTimes()[0]);
+  EXPECT_EQ(3000, store.startTimes()[1]);
+  EXPECT_EQ(5000, store.endTimes()[1]);
+}
@@ -0,0 +1,205 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/TrackImage.h>
+#include <TimedText/WebVTTParser.h>
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <cstring>
+using namespace TimedText;
+
+static void expectSameTree(const Node &a, const Node &b)
+{
+  EXPECT_EQ(a.type(), b.type());
+  EXPECT_EQ(a.element(), b.element());
+  if(a.element() == TextNode) {
+    EXPECT_STREQ(a.text().text(), b.text().text());
+  }
+  if(a.element() == VoiceNode) {
+    EXPECT_STREQ(a.voice().text(), b.voice().text());
+  }
+  if(a.element() == LangNode) {
+    EXPECT_STREQ(a.lang().text(), b.lang().text());
+  }
+  if(a.element() == TimestampNode) {
+    EXPECT_EQ(Milliseconds(a.timestamp()), Milliseconds(b.timestamp()));
+  }
+  if(a.type() == InternalNode) {
+    List<String> ac = a.applicableClasses(), bc = b.applicableClasses();
+    ASSERT_EQ(ac.count(), bc.count());
+    for(int i = 0; i < ac.count(); ++i)
+      EXPECT_STREQ(ac[i].text(), bc[i].text());
+  }
+  ASSERT_EQ(a.childCount(), b.childCount());
+  Node ca, cb;
+  for(int i = 0; i < a.childCount(); ++i) {
+    a.children().itemAt(i, ca);
+    b.children().itemAt(i, cb);
+    expectSameTree(ca, cb);
+  }
+}
+
+static void makeCues(List<Cue> &cues)
+{
+  Cue a(WebVTTCue, 1.000, 2.000, String("first"),
+        String("<v.loud Roger>Hello</v> <c.a.b>there</c> &amp; "
+               "<00:00:01.500><lang en-GB><i>world</i></lang>"));
+  a.applySettings(String("line:3 position:10% size:50% align:end"));
+  Cue b(WebVTTCue, 2.000, 3.500, String(),
+        String("<ruby>base<rt>top</rt></ruby>"));
+  Cue c(WebVTTCue, 4.000, 5.000, String(""), String());
+  EXPECT_TRUE(cues.push(a));
+  EXPECT_TRUE(cues.push(b));
+  EXPECT_TRUE(cues.push(c));
+}
+
+TEST(TrackImage,RoundTrip)
+{
+  List<Cue> cues;
+  makeCues(cues);
+  TrackImageWriter writer;
+  EXPECT_TRUE(writer.write(cues, TrackImageWriter::IncludeNodes));
+
+  // Images do not depend on where they are loaded
+  int size = writer.size();
+  char *copy = static_cast<char *>(::malloc(size));
+  ::memcpy(copy, writer.data(), size);
+  writer.clear();
+
+  TrackImage image;
+  EXPECT_TRUE(image.open(copy, size));
+  EXPECT_TRUE(image.hasNodes());
+  EXPECT_EQ(3, image.count());
+  EXPECT_EQ(2000, image.startTimes()[1]);
+  EXPECT_EQ(3500, image.endTimes()[1]);
+
+  Cue cue, original;
+  for(int i = 0; i < cues.count(); ++i) {
+    cues.itemAt(i, original);
+    EXPECT_TRUE(image.cueAt(i, cue));
+    EXPECT_EQ(original.type(), cue.type());
+    EXPECT_EQ(Milliseconds(original.startTime()), cue.startTime());
+    EXPECT_EQ(Milliseconds(original.endTime()), cue.endTime());
+    EXPECT_EQ(original.id().isNull(), cue.id().isNull());
+    EXPECT_EQ(original.id(), cue.id());
+    EXPECT_EQ(original.text().isNull(), cue.text().isNull());
+    EXPECT_EQ(original.text(), cue.text());
+    EXPECT_EQ(original.line(), cue.line());
+    EXPECT_EQ(original.snapToLines(), cue.snapToLines());
+    EXPECT_EQ(original.position(), cue.position());
+    EXPECT_EQ(original.size(), cue.size());
+    EXPECT_EQ(original.align(), cue.align());
+
+    Node expected, tree;
+    EXPECT_TRUE(WebVTTParser::cuetextToNodes(original.text(), expected));
+    EXPECT_TRUE(image.nodes(i, tree));
+    expectSameTree(expected, tree);
+    EXPECT_TRUE(cue.nodes(tree));
+    expectSameTree(expected, tree);
+  }
+  Node tree;
+  EXPECT_FALSE(image.cueAt(3, cue));
+  EXPECT_FALSE(image.nodes(3, tree));
+  image.close();
+  EXPECT_FALSE(image.isOpen());
+  EXPECT_EQ(0, image.count());
+  ::free(copy);
+}
+
+TEST(TrackImage,WithoutNodes)
+{
+  List<Cue> cues;
+  makeCues(cues);
+  TrackImageWriter writer;
+  EXPECT_TRUE(writer.write(cues));
+  TrackImage image;
+  EXPECT_TRUE(image.open(writer.data(), writer.size()));
+  EXPECT_FALSE(image.hasNodes());
+  Node tree;
+  EXPECT_FALSE(image.nodes(0, tree));
+  Cue cue;
+  EXPECT_TRUE(image.cueAt(0, cue));
+  EXPECT_STREQ("first", cue.id().text());
+  EXPECT_STREQ("first", image.id(0).text());
+  EXPECT_TRUE(image.id(1).isNull());
+
+  // An empty track is still a valid image
+  List<Cue> none;
+  EXPECT_TRUE(writer.write(none, TrackImageWriter::IncludeNodes));
+  EXPECT_TRUE(image.open(writer.data(), writer.size()));
+  EXPECT_EQ(0, image.count());
+}
+
+TEST(TrackImage,Invalid)
+{
+  List<Cue> cues;
+  makeCues(cues);
+  TrackImageWriter writer;
+  EXPECT_TRUE(writer.write(cues, TrackImageWriter::IncludeNodes));
+  int size = writer.size();
+  // Room for a misaligned copy
+  char *copy = static_cast<char *>(::malloc(size + 8));
+
+  TrackImage image;
+  ::memcpy(copy, writer.data(), size);
+  EXPECT_FALSE(image.open(copy, size - 1));
+  EXPECT_FALSE(image.open(copy, 16));
+  EXPECT_FALSE(image.open(0, size));
+
+  ::memcpy(copy + 1, writer.data(), size);
+  EXPECT_FALSE(image.open(copy + 1, size));
+
+  // Bad magic
+  ::memcpy(copy, writer.data(), size);
+  copy[0] = 'X';
+  EXPECT_FALSE(image.open(copy, size));
+
+  // Other versions
+  ::memcpy(copy, writer.data(), size);
+  uint32 version = TrackImage::Version + 1;
+  ::memcpy(copy + 4, &version, sizeof(version));
+  EXPECT_FALSE(image.open(copy, size));
+
+  // Other byte order
+  ::memcpy(copy, writer.data(), size);
+  uint32 order = 0x04030201;
+  ::memcpy(copy + 8, &order, sizeof(order));
+  EXPECT_FALSE(image.open(copy, size));
+  EXPECT_FALSE(image.isOpen());
+
+  // Text offsets beyond the text area give empty strings
+  ::memcpy(copy, writer.data(), size);
+  uint32 textOffsets;
+  ::memcpy(&textOffsets, copy + 36, sizeof(textOffsets));
+  uint32 bad = 0xfffffff0;
+  ::memcpy(copy + textOffsets + 4 * sizeof(uint32), &bad, sizeof(bad));
+  EXPECT_TRUE(image.open(copy, size));
+  EXPECT_TRUE(image.text(1).isEmpty());
+  EXPECT_TRUE(image.id(2).isEmpty());
+  EXPECT_STREQ("first", image.id(0).text());
+  ::free(copy);
+}
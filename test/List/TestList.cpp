@@ -26,6 +26,7 @@
 //
 
 #include <TimedText/List.h>
+#include <TimedText/String.h>
 #include <gtest/gtest.h>
 using namespace TimedText;
 
@@ -97,3 +98,96 @@ TEST(List,Primitive)
   testPrimitiveList<int64>();
   testPrimitiveList<uint64>();
 }
+
+TEST(List,Reserve)
+{
+  List<int> list;
+  EXPECT_TRUE(list.reserve(100));
+  EXPECT_LE(100, list.capacity());
+  int capacity = list.capacity();
+  for(int i=0; i < 100; ++i)
+    EXPECT_TRUE(list.push(i));
+  EXPECT_EQ(capacity, list.capacity());
+
+  // Reserving on a shared list detaches it
+  List<int> copy(list);
+  EXPECT_TRUE(copy.reserve(200));
+  EXPECT_LE(200, copy.capacity());
+  EXPECT_TRUE(copy.push(100));
+  EXPECT_EQ(100, list.size());
+  EXPECT_EQ(101, copy.size());
+  for(int i=0; i < 100; ++i) {
+    int a = -1, b = -1;
+    EXPECT_TRUE(list.itemAt(i, a));
+    EXPECT_TRUE(copy.itemAt(i, b));
+    EXPECT_EQ(i, a);
+    EXPECT_EQ(i, b);
+  }
+}
+
+TEST(List,DetachShared)
+{
+  List<String> list;
+  EXPECT_TRUE(list.push(String("The quick brown fox jumps over the lazy dog")));
+  EXPECT_TRUE(list.push(String("short")));
+  List<String> copy(list);
+  // begin() detaches 'copy', which must keep its own copies of the items
+  String &first = *copy.begin();
+  first = String("Changed");
+  String result;
+  EXPECT_TRUE(list.itemAt(0, result));
+  EXPECT_STREQ("The quick brown fox jumps over the lazy dog", result.text());
+  EXPECT_TRUE(copy.itemAt(0, result));
+  EXPECT_STREQ("Changed", result.text());
+  EXPECT_TRUE(copy.itemAt(1, result));
+  EXPECT_STREQ("short", result.text());
+}
+
+#if defined(TT_HAVE_RVALUE_REFS)
+TEST(List,MoveItems)
+{
+  List<String> list;
+  String a("This string is long enough to be allocated on the heap");
+  String b("So is this one, which is also longer than the inline size");
+  const char *textA = a.text();
+  EXPECT_TRUE(list.push(static_cast<String&&>(a)));
+  EXPECT_TRUE(list.unshift(static_cast<String&&>(b)));
+  EXPECT_TRUE(list.insert(1, String("middle")));
+  EXPECT_TRUE(a.isNull());
+  EXPECT_TRUE(b.isNull());
+  EXPECT_EQ(3, list.size());
+
+  String result;
+  EXPECT_TRUE(list.itemAt(0, result));
+  EXPECT_STREQ("So is this one, which is also longer than the inline size",
+               result.text());
+  EXPECT_TRUE(list.itemAt(1, result));
+  EXPECT_STREQ("middle", result.text());
+  EXPECT_TRUE(list.itemAt(2, result));
+  // The buffer was handed over rather than copied
+  EXPECT_EQ(textA, result.text());
+}
+#endif
+
+#if defined(TT_HAVE_VARIADIC_TEMPLATES)
+TEST(List,Emplace)
+{
+  List<String> list;
+  EXPECT_TRUE(list.emplaceBack("world", 5));
+  EXPECT_TRUE(list.emplace(0, "hello, there", 5));
+  EXPECT_TRUE(list.emplaceBack());
+  EXPECT_EQ(3, list.size());
+  String result;
+  EXPECT_TRUE(list.itemAt(0, result));
+  EXPECT_STREQ("hello", result.text());
+  EXPECT_TRUE(list.itemAt(1, result));
+  EXPECT_STREQ("world", result.text());
+  EXPECT_TRUE(list.itemAt(2, result));
+  EXPECT_TRUE(result.isNull());
+
+  List<int64> numbers;
+  for(int i=0; i < 10; ++i)
+    EXPECT_TRUE(numbers.emplaceBack(i));
+  EXPECT_EQ(10, numbers.size());
+}
+#endif
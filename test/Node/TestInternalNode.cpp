@@ -26,6 +26,7 @@
 //
 
 #include <TimedText/Node.h>
+#include "NodeData.h"
 #include <gtest/gtest.h>
 #include <stdlib.h>
 using namespace TimedText;
@@ -132,3 +133,83 @@ TEST(InternalNode,ConstEnd)
   ASSERT_NE(uintptr(0), uintptr((--it).i));
   EXPECT_EQ(leaf, *it);
 }
+
+TEST(InternalNode,CopyOnWrite)
+{
+  Node node(InternalNode,BoldNode);
+  Node leaf(LeafNode,TextNode);
+  EXPECT_TRUE(node.push(leaf));
+  Node copy = node;
+  EXPECT_EQ(node, copy);
+
+  // Modifying one handle leaves the other intact
+  EXPECT_TRUE(copy.push(Node(LeafNode,TimestampNode)));
+  EXPECT_NE(node, copy);
+  EXPECT_EQ(1, node.childCount());
+  EXPECT_EQ(2, copy.childCount());
+
+  // Children are shared until modified
+  Node child;
+  EXPECT_TRUE(copy.itemAt(0, child));
+  EXPECT_EQ(leaf, child);
+  EXPECT_TRUE(child.setText(String("Modified")));
+  EXPECT_NE(leaf, child);
+  EXPECT_STREQ("", leaf.text());
+
+  // Unshared nodes are modified in place
+  Node unique(InternalNode,ItalicNode);
+  Node other = unique;
+  other = Node();
+  NodeData *data = unique.d;
+  EXPECT_TRUE(unique.push(leaf));
+  EXPECT_EQ(data, unique.d);
+}
+
+TEST(InternalNode,Swap)
+{
+  Node a(InternalNode,BoldNode);
+  Node b(LeafNode,TextNode);
+  Node x = a, y = b;
+  a.swap(b);
+  EXPECT_EQ(y, a);
+  EXPECT_EQ(x, b);
+}
+
+#if defined(TT_HAVE_RVALUE_REFS)
+TEST(InternalNode,Move)
+{
+  Node a(InternalNode,BoldNode);
+  Node x = a;
+  Node b(static_cast<Node &&>(a));
+  EXPECT_EQ(x, b);
+  EXPECT_EQ(EmptyNode, a.type());
+  EXPECT_FALSE(a.push(Node(LeafNode,TextNode)));
+
+  Node c(LeafNode,TextNode);
+  c = static_cast<Node &&>(b);
+  EXPECT_EQ(x, c);
+  a = Node(InternalNode,ItalicNode);
+  EXPECT_EQ(ItalicNode, a.element());
+
+  // Moved-from handles hold a reference to the shared empty node, which
+  // they give up when destroyed
+  Node empty;
+  int refs = empty.d->ref;
+  for(int i = 0; i < 4; ++i) {
+    Node from(LeafNode,TextNode);
+    Node to(static_cast<Node &&>(from));
+    EXPECT_EQ(empty, from);
+  }
+  EXPECT_EQ(refs, int(empty.d->ref));
+
+  // Pushing a moved node takes it over, leaving the empty node behind
+  Node text(LeafNode,TextNode);
+  Node y = text;
+  EXPECT_TRUE(c.push(static_cast<Node &&>(text)));
+  EXPECT_EQ(empty, text);
+  EXPECT_EQ(1, c.childCount());
+  Node child;
+  EXPECT_TRUE(c.itemAt(0, child));
+  EXPECT_EQ(y, child);
+}
+#endif
@@ -42,6 +42,20 @@ TEST(TextNode,GetText)
   EXPECT_STREQ("", node.text());
 }
 
+TEST(TextNode,TextToUtf16)
+{
+  Node node(LeafNode,TextNode);
+  uint16 out[8];
+  int olen = -1;
+  EXPECT_TRUE(node.textToUtf16(out, 8, olen));
+  EXPECT_EQ(0, olen);
+  EXPECT_TRUE(node.setText(String("caf\xc3\xa9")));
+  EXPECT_TRUE(node.textToUtf16(out, 8, olen));
+  EXPECT_EQ(4, olen);
+  EXPECT_EQ('f', out[2]);
+  EXPECT_EQ(0xE9, out[3]);
+}
+
 TEST(TextNode,GetVoice)
 {
   Node node(LeafNode,TextNode);
@@ -0,0 +1,124 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#include <TimedText/SegmentedStringBuilder.h>
+#include <TimedText/StringBuilder.h>
+#include <gtest/gtest.h>
+using namespace TimedText;
+
+TEST(SegmentedStringBuilder,InitializeEmpty)
+{
+  SegmentedStringBuilder sb;
+  String str;
+  EXPECT_TRUE(sb.isEmpty());
+  EXPECT_EQ(0, sb.segmentCount());
+  EXPECT_TRUE(sb.toString(str));
+  EXPECT_TRUE(str.isEmpty());
+}
+
+TEST(SegmentedStringBuilder,Append)
+{
+  SegmentedStringBuilder sb(16);
+  SegmentedStringBuilder::Segment segments[8];
+  String str;
+  EXPECT_TRUE(sb.append("Trees cover "));
+  EXPECT_TRUE(sb.append("up a "));
+  EXPECT_TRUE(sb.append(uint32(0x2014)));
+  EXPECT_TRUE(sb.append(String("multitude")));
+  EXPECT_TRUE(sb.append(" of sins.", 9));
+  EXPECT_EQ(38, sb.length());
+  // Text is never split or moved, so a new segment is started whenever the
+  // last one is too full. "multitude" is at least half a segment long, and
+  // so is shared.
+  EXPECT_EQ(4, sb.segmentCount());
+  EXPECT_EQ(4, sb.segments(segments, 8));
+  EXPECT_EQ(12, segments[0].length);
+  EXPECT_EQ(0, ::memcmp("Trees cover ", segments[0].text, 12));
+  EXPECT_EQ(8, segments[1].length);
+  EXPECT_EQ(0, ::memcmp("up a \xe2\x80\x94", segments[1].text, 8));
+  EXPECT_EQ(9, segments[2].length);
+  EXPECT_EQ(0, ::memcmp(" of sins.", segments[3].text, 9));
+  EXPECT_EQ(1, sb.segments(segments, 8, 3));
+  EXPECT_EQ(9, segments[0].length);
+  EXPECT_TRUE(sb.toString(str));
+  EXPECT_STREQ("Trees cover up a \xe2\x80\x94multitude of sins.", str.text());
+
+  sb.clear();
+  EXPECT_TRUE(sb.isEmpty());
+  EXPECT_EQ(0, sb.segmentCount());
+}
+
+TEST(SegmentedStringBuilder,SharesLongStrings)
+{
+  SegmentedStringBuilder sb(16);
+  SegmentedStringBuilder::Segment segments[4];
+  String str("Trees cover up a multitude of sins.");
+  EXPECT_TRUE(sb.append(str));
+  EXPECT_EQ(1, sb.segments(segments, 4));
+  EXPECT_EQ(str.text(), segments[0].text);
+  EXPECT_EQ(str.length(), segments[0].length);
+  // A single shared String is returned as is
+  String result;
+  EXPECT_TRUE(sb.toString(result));
+  EXPECT_EQ(str.text(), result.text());
+
+  EXPECT_TRUE(sb.append("!"));
+  EXPECT_EQ(2, sb.segmentCount());
+  EXPECT_TRUE(sb.toString(result));
+  EXPECT_STREQ("Trees cover up a multitude of sins.!", result.text());
+
+  // Empty Strings add no segment
+  EXPECT_TRUE(sb.append(String("")));
+  EXPECT_EQ(2, sb.segmentCount());
+}
+
+TEST(SegmentedStringBuilder,AppendInvalid)
+{
+  // The replacement character makes the text too long for the first
+  // segment, so the rest of it starts another.
+  SegmentedStringBuilder sb(8);
+  String str;
+  EXPECT_TRUE(sb.append("sins \xc3("));
+  EXPECT_EQ(9, sb.length());
+  EXPECT_EQ(2, sb.segmentCount());
+  EXPECT_TRUE(sb.toString(str));
+  EXPECT_STREQ("sins \xef\xbf\xbd(", str.text());
+}
+
+TEST(SegmentedStringBuilder,Large)
+{
+  SegmentedStringBuilder sb;
+  StringBuilder line;
+  EXPECT_TRUE(line.append("00:00:01.000 --> 00:00:02.000\n"));
+  for(int i=0; i<100000; ++i)
+    EXPECT_TRUE(sb.append(line));
+  EXPECT_EQ(100000 * line.length(), sb.length());
+  String str;
+  EXPECT_TRUE(sb.toString(str));
+  EXPECT_EQ(sb.length(), str.length());
+  EXPECT_EQ(0, ::memcmp(line.text(), str.text() + 3000 * line.length(),
+                        line.length()));
+}
@@ -27,6 +27,11 @@
 
 #include <TimedText/String.h>
 #include <gtest/gtest.h>
+#include "StringData.h"
+#if __cplusplus >= 201103L
+#  include <thread>
+#  include <unordered_map>
+#endif
 using namespace TimedText;
 
 TEST(String,StartsWith)
@@ -56,6 +61,41 @@ TEST(String,Contains)
   EXPECT_TRUE(str.contains('C'));
 }
 
+TEST(String,IndexOf)
+{
+  String str("Phnglui mglw nafh Cthulhu R'lyeh wgah nagl fhtagn");
+  EXPECT_EQ(18, str.indexOf("Cthulhu"));
+  EXPECT_EQ(18, str.indexOf("Cthulhu", -1, 18));
+  EXPECT_EQ(-1, str.indexOf("Cthulhu", -1, 19));
+  EXPECT_EQ(43, str.indexOf("fhtagn"));
+  EXPECT_EQ(48, str.indexOf("n", -1, 47));
+  EXPECT_EQ(-1, str.indexOf("fhtagn!"));
+  EXPECT_EQ(-1, str.indexOf("Dagon"));
+
+  // Embedded NUL bytes are searched past, and matched
+  String nul("abc\0def\0ghi", 11);
+  EXPECT_EQ(8, nul.indexOf("g", 1));
+  EXPECT_EQ(4, nul.indexOf("def\0g", 5));
+
+  // Compare with a naive search, at every alignment around SIMD block sizes
+  char text[80];
+  for(int i=0; i<80; ++i)
+    text[i] = "ab"[(i * 7 / 3) & 1];
+  String bucket(text, sizeof(text));
+  const char *needles[] = { "a", "ab", "abb", "bab", "abbab", "babba",
+                            "aaa", "abbabbabbab" };
+  for(unsigned n=0; n<sizeof(needles)/sizeof(*needles); ++n) {
+    int nlen = ::strlen(needles[n]);
+    for(int from=0; from<80; ++from) {
+      int expected = -1;
+      for(int i=from; i+nlen<=80 && expected<0; ++i)
+        if(!::memcmp(text + i, needles[n], nlen))
+          expected = i;
+      EXPECT_EQ(expected, bucket.indexOf(needles[n], nlen, from));
+    }
+  }
+}
+
 TEST(String,Substring)
 {
   String str("Phnglui mglw nafh Cthulhu R'lyeh wgah nagl fhtagn");
@@ -99,3 +139,137 @@ TEST(String,SkipWhitespace)
   EXPECT_EQ(0, pos);
   EXPECT_STREQ("Trees cover up a multitude of sins.", str.text());
 }
+
+TEST(String,SmallString)
+{
+  // Strings up to SmallCapacity bytes live inline, longer ones on the heap
+  char text[String::SmallCapacity + 2];
+  ::memset(text, 'x', sizeof(text));
+  String small(text, String::SmallCapacity);
+  String large(text, String::SmallCapacity + 1);
+  EXPECT_TRUE(small.isSmall());
+  EXPECT_FALSE(large.isSmall());
+  EXPECT_EQ(String::SmallCapacity, small.length());
+  EXPECT_EQ(String::SmallCapacity + 1, large.length());
+  EXPECT_EQ('\0', small.text()[small.length()]);
+  EXPECT_EQ('\0', large.text()[large.length()]);
+
+  String copy(small);
+  EXPECT_TRUE(copy.isSmall());
+  EXPECT_STREQ(small.text(), copy.text());
+  EXPECT_NE(small.text(), copy.text());
+  copy = large;
+  EXPECT_FALSE(copy.isSmall());
+  EXPECT_EQ(large.text(), copy.text());
+  EXPECT_EQ(2, int(large.d->ref));
+}
+
+TEST(String,Append)
+{
+  String str("Trees cover");
+  str += String(" up a multitude of sins.");
+  EXPECT_STREQ("Trees cover up a multitude of sins.", str.text());
+  EXPECT_EQ(35, str.length());
+  String copy(str);
+  str += String("..");
+  EXPECT_STREQ("Trees cover up a multitude of sins...", str.text());
+  EXPECT_STREQ("Trees cover up a multitude of sins.", copy.text());
+  str = String("ab");
+  str += str;
+  EXPECT_STREQ("abab", str.text());
+  EXPECT_TRUE(str.isSmall());
+}
+
+TEST(String,NullAndEmpty)
+{
+  EXPECT_TRUE(String().isNull());
+  EXPECT_TRUE(String(0).isNull());
+  EXPECT_FALSE(String("").isNull());
+  EXPECT_TRUE(String("").isEmpty());
+  EXPECT_STREQ("", String().text());
+  String str("text");
+  str.clear();
+  EXPECT_TRUE(str.isNull());
+  EXPECT_EQ(0, str.length());
+}
+
+TEST(String,Equality)
+{
+  String a("Trees cover up a multitude of sins.");
+  String b("Trees cover up a multitude of sins.");
+  String c("Trees cover up a multitude of sins!");
+  EXPECT_TRUE(a == b);
+  EXPECT_FALSE(a != b);
+  EXPECT_TRUE(a != c);
+  EXPECT_TRUE(a == String(a));
+  EXPECT_TRUE(String("en-US") == String("en-US"));
+  EXPECT_TRUE(String("en-US") != String("en-GB"));
+  EXPECT_TRUE(String("en") != String("en-US"));
+  EXPECT_TRUE(String() == String(""));
+}
+
+TEST(String,Hash)
+{
+  String a("Trees cover up a multitude of sins.");
+  String b("Trees cover up a multitude of sins.");
+  EXPECT_EQ(a.hash(), b.hash());
+  EXPECT_NE(0u, a.d->hash);
+  EXPECT_EQ(a.hash(), String(a).hash());
+  EXPECT_EQ(String("en-US").hash(), String("en-US").hash());
+  EXPECT_NE(String("en-US").hash(), String("en-GB").hash());
+  // Hashes are dropped when the text changes
+  uint32 hash = a.hash();
+  a += String("..");
+  EXPECT_NE(hash, a.hash());
+  // Different hashes are enough to tell the strings apart
+  EXPECT_TRUE(a != b);
+}
+
+#if __cplusplus >= 201103L
+TEST(String,UnorderedMap)
+{
+  std::unordered_map<String, int, StringHash> map;
+  map[String("yellow")] = 1;
+  map[String("The Narrator, speaking slowly")] = 2;
+  EXPECT_EQ(1, map[String("yellow")]);
+  EXPECT_EQ(2, map[String("The Narrator, speaking slowly")]);
+  EXPECT_EQ(0u, map.count(String("blue")));
+}
+#endif
+
+#if __cplusplus >= 201103L && !defined(USE_NON_ATOMIC)
+static void copyRepeatedly(const String *str)
+{
+  for(int i=0; i<100000; ++i) {
+    String copy(*str);
+    EXPECT_EQ(str->length(), copy.length());
+  }
+}
+
+TEST(String,ConcurrentCopies)
+{
+  // Reference counts must stay exact when copies are made and released
+  // from several threads at once.
+  String str("Trees cover up a multitude of sins.");
+  std::thread threads[4];
+  for(int i=0; i<4; ++i)
+    threads[i] = std::thread(copyRepeatedly, &str);
+  for(int i=0; i<4; ++i)
+    threads[i].join();
+  EXPECT_EQ(1, int(str.d->ref));
+}
+#endif
+
+TEST(String,FromValidUtf8)
+{
+  const char text[] = "caf\xc3\xa9, a longer string stored on the heap";
+  String a = String::fromValidUtf8(text, 5);
+  EXPECT_STREQ("caf\xc3\xa9", a.text());
+  EXPECT_EQ(String(text, 5), a);
+  String b = String::fromValidUtf8(text, sizeof(text) - 1);
+  EXPECT_STREQ(text, b.text());
+  EXPECT_EQ(int(sizeof(text) - 1), b.length());
+  String c = String::fromValidUtf8(0, 0);
+  EXPECT_FALSE(c.isNull());
+  EXPECT_TRUE(c.isEmpty());
+}
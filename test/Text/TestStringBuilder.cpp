@@ -132,6 +132,53 @@ TEST(StringBuilder,Append)
   EXPECT_STREQ("Phnglui mglw nafh Cthulhu R'lyeh wgah nagl fhtagn", sb.text());
 }
 
+TEST(StringBuilder,AppendInvalid)
+{
+  StringBuilder sb;
+  EXPECT_TRUE(sb.append("Trees cover up a multitude of \xff sins."));
+  EXPECT_STREQ("Trees cover up a multitude of \xef\xbf\xbd sins.", sb.text());
+  EXPECT_TRUE(sb.append("\xc3"));
+  EXPECT_STREQ("Trees cover up a multitude of \xef\xbf\xbd sins."
+               "\xef\xbf\xbd", sb.text());
+}
+
+TEST(StringBuilder,TakeString)
+{
+  StringBuilder sb;
+  String str;
+  EXPECT_TRUE(sb.append("Trees cover up a multitude of sins."));
+  const char *buffer = sb.text();
+  EXPECT_TRUE(sb.takeString(str));
+  EXPECT_STREQ("Trees cover up a multitude of sins.", str.text());
+  EXPECT_EQ(35, str.length());
+  // The buffer is handed over, rather than copied
+  EXPECT_EQ(buffer, str.text());
+  EXPECT_TRUE(sb.isEmpty());
+  EXPECT_EQ(0, sb.capacity());
+
+  // Short text is copied, and the buffer kept
+  EXPECT_TRUE(sb.append("en-US"));
+  int capacity = sb.capacity();
+  EXPECT_TRUE(sb.takeString(str));
+  EXPECT_STREQ("en-US", str.text());
+  EXPECT_TRUE(sb.isEmpty());
+  EXPECT_EQ(capacity, sb.capacity());
+
+  EXPECT_TRUE(sb.takeString(str));
+  EXPECT_TRUE(str.isEmpty());
+  EXPECT_FALSE(str.isNull());
+
+  // A builder to be reused gets a new buffer as large as the old one
+  EXPECT_TRUE(sb.append("Trees cover up a multitude of sins."));
+  capacity = sb.capacity();
+  buffer = sb.text();
+  EXPECT_TRUE(sb.takeString(str, true));
+  EXPECT_STREQ("Trees cover up a multitude of sins.", str.text());
+  EXPECT_EQ(buffer, str.text());
+  EXPECT_TRUE(sb.isEmpty());
+  EXPECT_EQ(capacity, sb.capacity());
+}
+
 TEST(StringBuilder,Prepend)
 {
   bool result;
@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#include <TimedText/StringPool.h>
+#include <gtest/gtest.h>
+using namespace TimedText;
+
+TEST(StringPool,SharesLongStrings)
+{
+  StringPool pool;
+  const char text[] = "The Narrator, speaking slowly";
+  String a, b;
+  EXPECT_TRUE(pool.intern(text, -1, a));
+  EXPECT_TRUE(pool.intern(String(text), b));
+  EXPECT_STREQ(text, a.text());
+  EXPECT_EQ(a.text(), b.text());
+  EXPECT_EQ(1, pool.count());
+}
+
+TEST(StringPool,ShortStrings)
+{
+  // Strings which would fit inline are pooled all the same, so that they
+  // can be compared by pointer too
+  StringPool pool;
+  String a, b;
+  EXPECT_TRUE(pool.intern("en-US", -1, a));
+  EXPECT_TRUE(pool.intern(String("en-US"), b));
+  EXPECT_STREQ("en-US", a.text());
+  EXPECT_EQ(a.text(), b.text());
+  EXPECT_EQ(String("en-US").hash(), b.hash());
+  EXPECT_EQ(1, pool.count());
+
+  EXPECT_TRUE(pool.intern("", 0, a));
+  EXPECT_TRUE(pool.intern("", -1, b));
+  EXPECT_TRUE(a.isEmpty());
+  EXPECT_FALSE(a.isNull());
+  EXPECT_EQ(a.text(), b.text());
+  EXPECT_EQ(2, pool.count());
+
+  EXPECT_TRUE(pool.intern(0, 0, a));
+  EXPECT_TRUE(a.isNull());
+}
+
+TEST(StringPool,InvalidUtf8)
+{
+  // Replacement characters change the text, so it cannot be pooled
+  StringPool pool;
+  const char text[] = "\xff The Narrator, speaking slowly";
+  String a;
+  EXPECT_TRUE(pool.intern(text, -1, a));
+  EXPECT_STREQ("\xef\xbf\xbd The Narrator, speaking slowly", a.text());
+  EXPECT_EQ(0, pool.count());
+}
+
+TEST(StringPool,Capacity)
+{
+  StringPool pool(2);
+  String a, b, c;
+  EXPECT_TRUE(pool.intern("The first string in the pool", -1, a));
+  EXPECT_TRUE(pool.intern("The second string in the pool", -1, b));
+  EXPECT_EQ(2, pool.count());
+  // A full pool drops one String to make room for the next
+  EXPECT_TRUE(pool.intern("The third string in the pool", -1, c));
+  EXPECT_EQ(2, pool.count());
+  String d;
+  EXPECT_TRUE(pool.intern("The third string in the pool", -1, d));
+  EXPECT_EQ(c.text(), d.text());
+  // Strings dropped from the pool are still usable
+  EXPECT_STREQ("The first string in the pool", a.text());
+  EXPECT_STREQ("The second string in the pool", b.text());
+  pool.clear();
+  EXPECT_EQ(0, pool.count());
+  EXPECT_STREQ("The third string in the pool", c.text());
+}
@@ -26,6 +26,7 @@
 //
 
 #include <TimedText/Unicode.h>
+#include <TimedText/String.h>
 #include <gtest/gtest.h>
 using namespace TimedText;
 
@@ -134,4 +135,123 @@ TEST(Unicode,ToUtf8)
                               '\x00' };
     testToUtf8(codePoint,true,expected);
   }
-}
\ No newline at end of file
+}
+TEST(Unicode,CopyValidUtf8)
+{
+  char out[64];
+  // 40 bytes of ASCII, then multibyte characters
+  const char valid[] = "0123456789012345678901234567890123456789"
+                       "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80";
+  int len = sizeof(valid) - 1;
+  EXPECT_EQ(len, Unicode::copyValidUtf8(out, valid, len));
+  EXPECT_EQ(0, ::memcmp(out, valid, len));
+
+  // Stray trail byte
+  const char trail[] = "01234567890123456789012345678901234\x80 tail";
+  EXPECT_EQ(35, Unicode::copyValidUtf8(out, trail, sizeof(trail) - 1));
+  // Overlong encoding of '/'
+  const char overlong[] = "0123456789012345678\xc0\xaf";
+  EXPECT_EQ(19, Unicode::copyValidUtf8(out, overlong, sizeof(overlong) - 1));
+  // Character cut short by the end of the text
+  const char cut[] = "caf\xc3";
+  EXPECT_EQ(3, Unicode::copyValidUtf8(out, cut, sizeof(cut) - 1));
+  // Surrogate
+  const char surrogate[] = "a\xed\xa0\x80";
+  EXPECT_EQ(1, Unicode::copyValidUtf8(out, surrogate, sizeof(surrogate) - 1));
+}
+
+// ASCII which ends on a block boundary must not be read or written past
+// its end. The buffers are exactly as long as the text, so that a memory
+// checker catches any access beyond it.
+TEST(Unicode,CopyValidUtf8BlockBoundary)
+{
+  static const int sizes[] = { 16, 32, 48, 64 };
+  for(int s=0; s < int(sizeof(sizes) / sizeof(sizes[0])); ++s) {
+    int len = sizes[s];
+    char *in = new char[len];
+    char *out = new char[len];
+    for(int i=0; i<len; ++i)
+      in[i] = char('a' + i % 26);
+    EXPECT_EQ(len, Unicode::copyValidUtf8(out, in, len));
+    EXPECT_EQ(0, ::memcmp(out, in, len));
+    delete [] in;
+    delete [] out;
+  }
+}
+
+// Strings with invalid sequences are the same as if they had been passed
+// through toValidUtf8() in full.
+TEST(Unicode,ValidatedString)
+{
+  const char *inputs[] = {
+    "0123456789012345678901234567890123456789\x80 tail",
+    "caf\xc3 au lait, with a long enough tail to be on the heap",
+    "\xff\xfe",
+    "\xe2\x82\xac\xed\xa0\x80\xe2\x82\xac",
+  };
+  for(unsigned i=0; i<sizeof(inputs)/sizeof(*inputs); ++i) {
+    int len = ::strlen(inputs[i]);
+    char expected[256];
+    int elen = 0;
+    Unicode::toValidUtf8(expected, Unicode::utf8Length(inputs[i], len) + 1,
+                         elen, inputs[i], len);
+    String str(inputs[i], len);
+    EXPECT_EQ(elen, str.length());
+    EXPECT_EQ(0, ::memcmp(expected, str.text(), elen));
+  }
+}
+
+TEST(Unicode,ToUtf16)
+{
+  // 20 bytes of ASCII, then 2, 3 and 4 byte sequences, then more ASCII
+  const char utf8[] = "01234567890123456789"
+                      "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80"
+                      " 0123456789012345";
+  const uint16 expected[] = {
+    '0','1','2','3','4','5','6','7','8','9',
+    '0','1','2','3','4','5','6','7','8','9',
+    'c','a','f',0xE9,' ',0x20AC,' ',0xD83D,0xDE00,
+    ' ','0','1','2','3','4','5','6','7','8','9','0','1','2','3','4','5'
+  };
+  const int units = sizeof(expected) / sizeof(*expected);
+  int len = sizeof(utf8) - 1;
+  EXPECT_EQ(units, Unicode::utf16Length(utf8, len));
+  uint16 out[64];
+  int olen = 0;
+  EXPECT_TRUE(Unicode::toUtf16(out, 64, olen, utf8, len));
+  EXPECT_EQ(units, olen);
+  EXPECT_EQ(0, ::memcmp(expected, out, units * sizeof(uint16)));
+
+  // Output is cut short, rather than overflowing a small buffer
+  EXPECT_FALSE(Unicode::toUtf16(out, 28, olen, utf8, len));
+  EXPECT_EQ(27, olen);
+  EXPECT_FALSE(Unicode::toUtf16(out, 10, olen, utf8, len));
+  EXPECT_EQ(10, olen);
+
+  String str(utf8, len);
+  EXPECT_EQ(units, str.utf16Length());
+  EXPECT_TRUE(str.toUtf16(out, 64, olen));
+  EXPECT_EQ(units, olen);
+  EXPECT_EQ(0, ::memcmp(expected, out, units * sizeof(uint16)));
+}
+
+TEST(Unicode,Utf8ToUCS4)
+{
+  // A sequence which ends the text is decoded, not reported as truncated
+  const char utf8[] = "a\xc3\xa9\xe2\x82\xac";
+  int len = sizeof(utf8) - 1;
+  int position = 0;
+  EXPECT_EQ(uint32('a'), Unicode::utf8ToUCS4(utf8, len, position));
+  EXPECT_EQ(uint32(0xE9), Unicode::utf8ToUCS4(utf8, len, position));
+  EXPECT_EQ(3, position);
+  EXPECT_EQ(uint32(0x20AC), Unicode::utf8ToUCS4(utf8, len, position));
+  EXPECT_EQ(len, position);
+
+  // A sequence which is cut short is
+  position = 1;
+  EXPECT_EQ(uint32(-1), Unicode::utf8ToUCS4(utf8, 2, position));
+  // Stray trail bytes are skipped, but not past the end of the text
+  position = 0;
+  EXPECT_EQ(uint32(0xFFFD), Unicode::utf8ToUCS4("\x82\xac", 2, position));
+  EXPECT_EQ(2, position);
+}
@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/WebVTTParser.h>
+#include <TimedText/CuetextCache.h>
+#include <gtest/gtest.h>
+using namespace TimedText;
+
+static Cue makeCue(const char *text)
+{
+  Cue cue(WebVTTCue);
+  cue.setText(String(text));
+  return cue;
+}
+
+TEST(CuetextCache,SharesIdenticalText)
+{
+  CuetextCache cache;
+  Cue a = makeCue("<c.yellow>Roll up</c>");
+  Cue b = makeCue("<c.yellow>Roll up</c>");
+  Cue c = makeCue("<c.yellow>Roll down</c>");
+  EXPECT_TRUE(WebVTTParser::parseCuetext(a, cache));
+  EXPECT_TRUE(WebVTTParser::parseCuetext(b, cache));
+  EXPECT_TRUE(WebVTTParser::parseCuetext(c, cache));
+  EXPECT_EQ(2, cache.count());
+  Node na, nb, nc;
+  EXPECT_TRUE(a.nodes(na));
+  EXPECT_TRUE(b.nodes(nb));
+  EXPECT_TRUE(c.nodes(nc));
+  EXPECT_TRUE(na == nb);
+  EXPECT_TRUE(na != nc);
+}
+
+TEST(CuetextCache,CopyOnWrite)
+{
+  CuetextCache cache;
+  Cue a = makeCue("<b>Karaoke</b>");
+  Cue b = makeCue("<b>Karaoke</b>");
+  WebVTTParser::parseCuetext(a, cache);
+  WebVTTParser::parseCuetext(b, cache);
+
+  // Modifying the root through a handle copies it first
+  Node root, shared;
+  a.nodes(root);
+  b.nodes(shared);
+  EXPECT_TRUE(root.push(Node(TextNode)));
+  EXPECT_TRUE(root != shared);
+  EXPECT_EQ(2, root.childCount());
+  EXPECT_EQ(1, shared.childCount());
+  EXPECT_TRUE(a.setNodes(root));
+
+  // So does modifying a descendant
+  Node bold, text;
+  EXPECT_TRUE(shared.itemAt(0, bold));
+  EXPECT_TRUE(bold.itemAt(0, text));
+  EXPECT_TRUE(text.setText(String("Changed")));
+  EXPECT_STREQ("Changed", text.text());
+  Node original;
+  b.nodes(shared);
+  shared.itemAt(0, bold);
+  bold.itemAt(0, original);
+  EXPECT_STREQ("Karaoke", original.text());
+
+  // Cues parsed later still share the unmodified tree
+  Cue c = makeCue("<b>Karaoke</b>");
+  WebVTTParser::parseCuetext(c, cache);
+  Node nc;
+  c.nodes(nc);
+  EXPECT_TRUE(nc == shared);
+}
+
+TEST(CuetextCache,Capacity)
+{
+  CuetextCache cache(2);
+  Node tree;
+  EXPECT_TRUE(WebVTTParser::cuetextToNodes(String("one"), tree, cache));
+  EXPECT_TRUE(WebVTTParser::cuetextToNodes(String("two"), tree, cache));
+  EXPECT_EQ(2, cache.count());
+  // A full cache drops one tree to make room for the next
+  EXPECT_TRUE(WebVTTParser::cuetextToNodes(String("three"), tree, cache));
+  EXPECT_EQ(2, cache.count());
+  EXPECT_TRUE(cache.find(String("three"), tree));
+  EXPECT_NE(cache.find(String("one"), tree), cache.find(String("two"), tree));
+  const char *more[] = { "four", "five", "six", "seven", "eight" };
+  for(int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(WebVTTParser::cuetextToNodes(String(more[i]), tree, cache));
+    EXPECT_EQ(2, cache.count());
+    EXPECT_TRUE(cache.find(String(more[i]), tree));
+  }
+  cache.clear();
+  EXPECT_EQ(0, cache.count());
+  EXPECT_FALSE(cache.find(String("three"), tree));
+}
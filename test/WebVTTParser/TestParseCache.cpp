@@ -0,0 +1,180 @@
+//
+// Copyright (c) 2013 Caitlin Potter and Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//  * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <TimedText/ParseCache.h>
+#include <TimedText/WebVTTParser.h>
+#include "Utility.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#if __cplusplus >= 201103L
+#  include <thread>
+#endif
+using namespace TimedText;
+
+static const char document[] =
+"WEBVTT\n"
+"\n"
+"00:00:00.000 --> 00:00:04.667\n"
+"Cue <b>#1</b>\n"
+"\n"
+"00:00:09.000 --> 00:00:14.324\n"
+"Cue #2\n";
+
+TEST(ParseCache,Hits)
+{
+  ParseCache cache;
+  List<Cue> first, second;
+  EXPECT_TRUE(cache.parse(document, -1, first));
+  EXPECT_EQ(2, first.count());
+  EXPECT_EQ(1, cache.misses());
+  EXPECT_EQ(0, cache.hits());
+  EXPECT_EQ(1, cache.count());
+  EXPECT_LT(int(sizeof(document)), cache.cost());
+
+  // The same document, in another buffer, is not parsed again
+  char copy[sizeof(document)];
+  ::memcpy(copy, document, sizeof(document));
+  EXPECT_TRUE(cache.parse(copy, -1, second));
+  EXPECT_EQ(1, cache.hits());
+  ASSERT_EQ(2, second.count());
+  EXPECT_STREQ(first[0].text().text(), second[0].text().text());
+  EXPECT_STREQ(first[1].text().text(), second[1].text().text());
+  EXPECT_EQ(4667, second[0].endTime());
+
+  // Each caller has cues of its own, which it may change
+  EXPECT_TRUE(first[0] != second[0]);
+  Node tree;
+  EXPECT_TRUE(WebVTTParser::parseCuetext(second[0]));
+  EXPECT_TRUE(second[0].nodes(tree));
+  EXPECT_EQ(InternalTextNode, tree.element());
+  EXPECT_TRUE(cache.parse(document, -1, second));
+  EXPECT_FALSE(second[0].nodes(tree) && tree.type() != EmptyNode);
+
+  // Parsing the cue text is another entry
+  EXPECT_TRUE(cache.parse(document, -1, second, ParseCache::ParseCuetext));
+  EXPECT_EQ(2, cache.misses());
+  EXPECT_EQ(2, cache.count());
+  EXPECT_TRUE(second[0].nodes(tree));
+  EXPECT_EQ(InternalTextNode, tree.element());
+  EXPECT_EQ(2, tree.childCount());
+  // The trees are shared by every caller
+  Node other;
+  EXPECT_TRUE(cache.parse(document, -1, first, ParseCache::ParseCuetext));
+  EXPECT_TRUE(first[0].nodes(other));
+  EXPECT_EQ(tree, other);
+
+  // A different document
+  copy[sizeof(document) - 3] = '3';
+  EXPECT_TRUE(cache.parse(copy, -1, second));
+  EXPECT_EQ(3, cache.misses());
+  EXPECT_EQ(3, cache.count());
+
+  cache.clear();
+  EXPECT_EQ(0, cache.count());
+  EXPECT_EQ(0, cache.cost());
+}
+
+TEST(ParseCache,Failure)
+{
+  ParseCache cache;
+  List<Cue> cues;
+  EXPECT_FALSE(cache.parse("WEBVTTT\n\n", -1, cues));
+  EXPECT_FALSE(cache.parse("WEBVTTT\n\n", -1, cues));
+  EXPECT_EQ(1, cache.misses());
+  EXPECT_EQ(1, cache.hits());
+  EXPECT_FALSE(cache.parse(0, 0, cues));
+}
+
+TEST(ParseCache,SameHash)
+{
+  // Documents are compared on a hit, so one which has the same hash and
+  // length as a cached document is not taken for it
+  ParseCache cache;
+  List<Cue> cues;
+  EXPECT_TRUE(cache.parse(document, -1, cues));
+  int len = sizeof(document) - 1;
+  char other[sizeof(document)];
+  ::memcpy(other, document, sizeof(document));
+  other[len - 3] = '3';
+  uint64 hash = hashBytes64(document, len, 0);
+  EXPECT_TRUE(cache.find(hash, document, len, 0) != 0);
+  EXPECT_TRUE(cache.find(hash, other, len, 0) == 0);
+}
+
+TEST(ParseCache,Budget)
+{
+  // Room for a handful of small documents
+  ParseCache cache(4096);
+  EXPECT_EQ(4096, cache.budget());
+  char text[128];
+  List<Cue> cues;
+  for(int i = 0; i < 100; ++i) {
+    snprintf(text, sizeof(text),
+             "WEBVTT\n\n00:00:00.000 --> 00:00:01.000\nDocument %d\n", i);
+    EXPECT_TRUE(cache.parse(text, -1, cues));
+    EXPECT_EQ(1, cues.count());
+    EXPECT_GE(4096, cache.cost());
+  }
+  EXPECT_LT(0, cache.count());
+  EXPECT_GT(100, cache.count());
+
+  // The most recently used documents are kept
+  EXPECT_TRUE(cache.parse(text, -1, cues));
+  EXPECT_EQ(100, cache.misses());
+  EXPECT_EQ(1, cache.hits());
+  snprintf(text, sizeof(text),
+           "WEBVTT\n\n00:00:00.000 --> 00:00:01.000\nDocument %d\n", 0);
+  EXPECT_TRUE(cache.parse(text, -1, cues));
+  EXPECT_EQ(101, cache.misses());
+}
+
+#if __cplusplus >= 201103L
+static void parseRepeatedly(ParseCache *cache, List<Cue> *result)
+{
+  for(int i = 0; i < 100; ++i)
+    EXPECT_TRUE(cache->parse(document, -1, *result));
+}
+
+TEST(ParseCache,Concurrent)
+{
+  // Concurrent requests for the same document share a single parse
+  ParseCache cache;
+  List<Cue> results[4];
+  std::thread threads[4];
+  for(int i = 0; i < 4; ++i)
+    threads[i] = std::thread(parseRepeatedly, &cache, &results[i]);
+  for(int i = 0; i < 4; ++i)
+    threads[i].join();
+  EXPECT_EQ(1, cache.misses());
+  EXPECT_EQ(399, cache.hits());
+  for(int i = 1; i < 4; ++i) {
+    ASSERT_EQ(2, results[i].count());
+    EXPECT_STREQ(results[0][0].text().text(), results[i][0].text().text());
+  }
+}
+#endif
@@ -28,6 +28,7 @@
 #include <TimedText/WebVTTParser.h>
 #include <TimedText/SynchronousBuffer.h>
 #include <gtest/gtest.h>
+#include <cstring>
 using namespace TimedText;
 
 void testParseHeader(const char *text, bool shouldFinal,
@@ -168,3 +169,101 @@ TEST(SynchronousWebVTTParser,RetrieveCues)
   EXPECT_EQ(14324, cue2.endTime());
   EXPECT_STREQ("Cue #2", cue2.text());
 }
+
+const char unorderedWebVTTDocument[] =
+"WEBVTT\n"
+"\n"
+"00:00:03.000 --> 00:00:04.000\n"
+"C\n"
+"\n"
+"00:00:01.000 --> 00:00:02.000\n"
+"A\n"
+"\n"
+"00:00:02.000 --> 00:00:03.000\n"
+"B\n"
+"\n"
+"00:00:06.000 --> 00:00:07.000\n"
+"E\n"
+"\n"
+"00:00:05.000 --> 00:00:06.000\n"
+"D\n";
+
+static void
+expectCueTexts(const List<Cue> &cues, const char *texts)
+{
+  int n = int(::strlen(texts));
+  EXPECT_EQ(n, cues.count());
+  for(int i = 0; i < n && i < cues.count(); ++i) {
+    char text[2] = { texts[i], '\0' };
+    EXPECT_STREQ(text, cues.begin()[i].text());
+  }
+}
+
+TEST(SynchronousWebVTTParser,ReorderCues)
+{
+  SynchronousBuffer buffer;
+  WebVTTParser parser(buffer);
+  EXPECT_EQ(-1, parser.reorderWindow());
+  parser.setReorderWindow(2000);
+  EXPECT_EQ(2000, parser.reorderWindow());
+  EXPECT_TRUE(buffer.refill(unorderedWebVTTDocument,true));
+  EXPECT_TRUE(parser.parse());
+  List<Cue> cues;
+  parser.parsedCues(cues);
+  expectCueTexts(cues, "ABCDE");
+  EXPECT_EQ(0, parser.lateCueCount());
+
+  // Without a window, cues keep document order
+  SynchronousBuffer buffer2;
+  WebVTTParser parser2(buffer2);
+  EXPECT_TRUE(buffer2.refill(unorderedWebVTTDocument,true));
+  EXPECT_TRUE(parser2.parse());
+  parser2.parsedCues(cues);
+  expectCueTexts(cues, "CABED");
+}
+
+TEST(SynchronousWebVTTParser,ReorderLiveCues)
+{
+  class TestClient : public Client
+  {
+  public:
+    TestClient() : timesDispatched(0) {}
+    void cuesAvailable() { ++timesDispatched; }
+    void lateCue(const Cue &cue) { late = cue; }
+    int timesDispatched;
+    Cue late;
+  };
+  TestClient client;
+  SynchronousBuffer buffer;
+  WebVTTParser parser(buffer, &client);
+  parser.setReorderWindow(1000);
+  List<Cue> cues;
+
+  // Cues are only emitted once a cue starting a second later arrives
+  EXPECT_TRUE(buffer.refill("WEBVTT\n\n"
+                            "00:02.000 --> 00:03.000\nB\n\n"
+                            "00:01.500 --> 00:03.000\nA\n\n"));
+  EXPECT_FALSE(parser.parse());
+  parser.parsedCues(cues);
+  EXPECT_EQ(0, cues.count());
+  EXPECT_EQ(0, client.timesDispatched);
+  EXPECT_TRUE(buffer.refill("00:03.000 --> 00:04.000\nC\n\n"));
+  EXPECT_FALSE(parser.parse());
+  parser.parsedCues(cues);
+  expectCueTexts(cues, "AB");
+  EXPECT_EQ(1, client.timesDispatched);
+
+  // A cue starting before one already emitted is passed on at once
+  EXPECT_TRUE(buffer.refill("00:01.000 --> 00:02.000\nL\n\n"));
+  EXPECT_FALSE(parser.parse());
+  EXPECT_EQ(1, parser.lateCueCount());
+  EXPECT_STREQ("L", client.late.text());
+  parser.parsedCues(cues);
+  expectCueTexts(cues, "L");
+
+  // The rest are emitted when the document ends
+  EXPECT_TRUE(buffer.refill("00:03.500 --> 00:04.000\nD\n", true));
+  EXPECT_TRUE(parser.parse());
+  parser.parsedCues(cues);
+  expectCueTexts(cues, "CD");
+}
@@ -26,6 +26,7 @@
 //
 
 #include <TimedText/WebVTTParser.h>
+#include <TimedText/StringPool.h>
 #include <gtest/gtest.h>
 using namespace TimedText;
 
@@ -166,3 +167,69 @@ TEST(WebVTTCueTextParser,RubyBaseNestedMarkup)
         EXPECT_EQ(TextNode, text.element());
         EXPECT_STREQ("Hello!", text.text());
 }
+
+static String
+plainText(const char *text, int flags = WebVTTParser::PlainTextDefault)
+{
+  StringBuilder builder;
+  String result;
+  EXPECT_TRUE(WebVTTParser::cuetextToPlainText(String(text), builder, flags));
+  builder.toString(result);
+  return result;
+}
+
+TEST(WebVTTCueTextParser,PlainText)
+{
+  EXPECT_STREQ("Hello, world <>",
+               plainText("<c.big>Hello</c>, <i><b>world</b></i> &lt;&gt;"));
+  EXPECT_STREQ("Timestamps are dropped",
+               plainText("Timestamps <00:01.000>are <00:02.000>dropped"));
+  EXPECT_STREQ("", plainText(""));
+}
+
+TEST(WebVTTCueTextParser,PlainTextAppends)
+{
+  StringBuilder builder;
+  String result;
+  EXPECT_TRUE(WebVTTParser::cuetextToPlainText(String("<b>one</b>"),
+                                               builder));
+  EXPECT_TRUE(WebVTTParser::cuetextToPlainText(String(" <i>two</i>"),
+                                               builder));
+  builder.toString(result);
+  EXPECT_STREQ("one two", result);
+}
+
+TEST(WebVTTCueTextParser,PlainTextRuby)
+{
+  const char *text = "<ruby>\xe6\xbc\xa2<rt>kan</rt>\xe5\xad\x97<rt>ji</ruby>!";
+  EXPECT_STREQ("\xe6\xbc\xa2\xe5\xad\x97!", plainText(text));
+  EXPECT_STREQ("\xe6\xbc\xa2(kan)\xe5\xad\x97(ji)!",
+               plainText(text, WebVTTParser::IncludeRubyText));
+  // <rt> outside of <ruby> is ignored, like cuetextToNodes() does
+  EXPECT_STREQ("not ruby text", plainText("not <rt>ruby</rt> text"));
+}
+
+TEST(WebVTTCueTextParser,PlainTextVoice)
+{
+  const char *text = "<v Roger Bingham>We are in New York City</v>";
+  EXPECT_STREQ("We are in New York City", plainText(text));
+  EXPECT_STREQ("Roger Bingham: We are in New York City",
+               plainText(text, WebVTTParser::IncludeVoicePrefix));
+  EXPECT_STREQ("Anonymous",
+               plainText("<v>Anonymous", WebVTTParser::IncludeVoicePrefix));
+}
+
+TEST(WebVTTCueTextParser,InternedAnnotations)
+{
+  StringPool strings;
+  Node a, b, voice;
+  String cuetext("<v The Narrator, speaking slowly>Hello</v>");
+  EXPECT_TRUE(WebVTTParser::cuetextToNodes(cuetext, a, strings));
+  EXPECT_TRUE(WebVTTParser::cuetextToNodes(cuetext, b, strings));
+  EXPECT_TRUE(a.itemAt(0, voice));
+  String first = voice.voice();
+  EXPECT_TRUE(b.itemAt(0, voice));
+  EXPECT_STREQ("The Narrator, speaking slowly", first.text());
+  EXPECT_EQ(first.text(), voice.voice().text());
+  EXPECT_EQ(1, strings.count());
+}
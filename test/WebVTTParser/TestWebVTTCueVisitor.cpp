@@ -163,4 +163,130 @@ TEST(WebVTTCueVisitor,SkipBoldBranches)
   // of the bold nodes)
   EXPECT_EQ(6, visitor.visited);
   EXPECT_EQ(3, visitor.textTokens);
-}
\ No newline at end of file
+}
+TEST(WebVTTCueVisitor,StaticTraversal)
+{
+  // Not derived from NodeVisitor, the members are found statically
+  struct Visitor
+  {
+    Visitor() : visited(0), depth(0), deepest(0) {}
+    bool enter(const Node &node) {
+      if(node.element() == BoldNode)
+        return false;
+      if(++depth > deepest)
+        deepest = depth;
+      return true;
+    }
+    void leave(const Node &node) {
+      --depth;
+    }
+    void visit(const Node &node) {
+      if(node.element() == TextNode)
+        text += node.text();
+      visited++;
+    }
+    String text;
+    int visited;
+    int depth;
+    int deepest;
+  };
+  Visitor visitor;
+  Cue cue(WebVTTCue);
+  cue.setText(String(webvttCueSkipBold));
+  WebVTTParser::parseCuetext(cue);
+  EXPECT_TRUE(traverse(cue, visitor));
+  EXPECT_STREQ("I don't want to visit evil henchmen", visitor.text);
+  EXPECT_EQ(0, visitor.depth);
+  EXPECT_EQ(1, visitor.deepest);
+  EXPECT_EQ(6, visitor.visited);
+}
+
+TEST(WebVTTCueVisitor,DeepTraversal)
+{
+  struct Visitor
+  {
+    Visitor() : depth(0), deepest(0), leaves(0) {}
+    bool enter(const Node &node) {
+      if(++depth > deepest)
+        deepest = depth;
+      return true;
+    }
+    void leave(const Node &node) {
+      --depth;
+    }
+    void visit(const Node &node) {
+      if(node.type() == LeafNode)
+        ++leaves;
+    }
+    int depth;
+    int deepest;
+    int leaves;
+  };
+  const int levels = 10000;
+  // Built from the bottom up, as a Node is copied if it's modified after
+  // being attached to its parent.
+  Node node(TextNode);
+  for(int i=0; i<levels; ++i) {
+    Node parent(ItalicNode);
+    parent.push(node);
+    node.swap(parent);
+  }
+  Node root(InternalTextNode);
+  root.push(node);
+  node = Node();
+  Visitor visitor;
+  EXPECT_TRUE(traverse(root, visitor));
+  EXPECT_EQ(0, visitor.depth);
+  EXPECT_EQ(levels, visitor.deepest);
+  EXPECT_EQ(1, visitor.leaves);
+
+  // Unlink the chain from the top down, so that releasing it doesn't recurse
+  // through every level.
+  Node child;
+  root.pop(node);
+  while(node.pop(child))
+    node.swap(child);
+}
+
+TEST(WebVTTCueVisitor,VisitSharedTree)
+{
+  // Changes made through handles during a visit must not show through in
+  // other handles to the same tree. Visitors which take a mutable Node are
+  // given a copy of its handle.
+  class Visitor : public NodeVisitor
+  {
+  public:
+    Visitor(Node &tree) : tree(tree), visited(0) {}
+    void visit(Node &node) {
+      if(node.element() == TextNode)
+        node.setText(String("Changed"));
+      if(!visited++)
+        tree.push(Node(LeafNode,TextNode));
+    }
+    Node &tree;
+    int visited;
+  };
+  Cue cue(WebVTTCue);
+  cue.setText(String("<b>Bold</b> text"));
+  WebVTTParser::parseCuetext(cue);
+  Node tree;
+  ASSERT_TRUE(cue.nodes(tree));
+  Node shared = tree;
+  Visitor visitor(tree);
+  shared.visit(visitor);
+  EXPECT_EQ(3, visitor.visited);
+  EXPECT_NE(shared, tree);
+  EXPECT_EQ(2, shared.childCount());
+  EXPECT_EQ(3, tree.childCount());
+
+  // The text of the shared tree is untouched
+  Node bold, text;
+  ASSERT_TRUE(shared.itemAt(0, bold));
+  ASSERT_TRUE(bold.itemAt(0, text));
+  EXPECT_STREQ("Bold", text.text());
+  ASSERT_TRUE(shared.itemAt(1, text));
+  EXPECT_STREQ(" text", text.text());
+  Node cueTree;
+  ASSERT_TRUE(cue.nodes(cueTree));
+  EXPECT_EQ(shared, cueTree);
+}
@@ -187,6 +187,14 @@ TEST(WebVTTTokenizer,StartTagWithClassesAndAnnotation)
   testTokenizeStartTag("<rt.foo.bar.baz tatotop>", "rt", "tatotop", triClass);
 }
 
+// A multi-byte character ending the input is part of the tag, rather than
+// being taken for the end of the input
+TEST(WebVTTTokenizer,StartTagEndingInMultibyteCharacter)
+{
+  testTokenizeStartTag("<v Zo\xc3\xab", "v", "Zo\xc3\xab");
+  testTokenizeStartTag("<lang \xc3\xa9", "lang", "\xc3\xa9");
+}
+
 // Test a nameless start tag with single class
 TEST(WebVTTTokenizer,NamelessStartTagWithAnnotation)
 {
@@ -360,3 +368,15 @@ TEST(WebVTTTokenizer,TextTag)
   testTokenizeText("Phnglui mglw nafh Cthulhu <ruby>R'lyeh wgah nagl <rt>fhtagn",
                    "Phnglui mglw nafh Cthulhu ");
 }
+
+// Runs of text in the data state are appended without being decoded
+TEST(WebVTTTokenizer,TextRun)
+{
+  testTokenizeText("Line one\r\nline two\rline three",
+                   "Line one\nline two\nline three");
+  testTokenizeText("Caf\xc3\xa9", "Caf\xc3\xa9");
+  testTokenizeText("\xe3\x81\x93\xe3\x82\x93 &lt;3 \xf0\x9f\x90\x99<b>",
+                   "\xe3\x81\x93\xe3\x82\x93 <3 \xf0\x9f\x90\x99");
+  testTokenizeText("A run of text which is longer than sixteen bytes &amp",
+                   "A run of text which is longer than sixteen bytes &amp");
+}